@@ -81,6 +81,7 @@ struct PartsBasedDetectorCell: public object_recognition_core::db::bases::ModelR
 	spore<bool> remove_planes_;
 	spore<std::string> model_file_;
 	spore<float> max_overlap_;
+	spore<bool> fixed_point_;
 	spore<ObjectDbPtr> object_db_;
 
 	// I/O
@@ -123,6 +124,8 @@ struct PartsBasedDetectorCell: public object_recognition_core::db::bases::ModelR
 				"The path to the model file").required(true);
 		params.declare(&PartsBasedDetectorCell::max_overlap_, "max_overlap",
 				"The maximum overlap allowed between object detections", 0.1);
+		params.declare(&PartsBasedDetectorCell::fixed_point_, "fixed_point",
+				"Run the dynamic program in 32-bit fixed point", false);
 	}
 
 	/*! @brief declare the I/O of the detector
@@ -179,6 +182,7 @@ struct PartsBasedDetectorCell: public object_recognition_core::db::bases::ModelR
 		// create the PartsBasedDetector and distribute the model parameters
 		detector_.reset(new PartsBasedDetector<double>);
 		detector_->distributeModel(model);
+		detector_->setFixedPoint(*fixed_point_);
 
 		// set the model_name
 		model_name_ = model.name();
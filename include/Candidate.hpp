@@ -45,6 +45,7 @@
 #include "types.hpp"
 #include "Rect3.hpp"
 #include "Math.hpp"
+#include "nms.hpp"
 
 /*! @class Candidate
  *  @brief detection candidate
@@ -133,9 +134,17 @@ public:
 	 *
 	 * Given an image, its depth correspondences and a candidate,
 	 * return an approximate 3D bounding box which encapsulates the object
+	 *
+	 * The valid depths under the parts are accumulated into a fixed-bin
+	 * histogram. The sorted depths are then resampled at 400 quantiles from the
+	 * cumulative histogram, and the depth extent is found by walking out from the
+	 * median until the Gaussian-derivative of the quantiles exceeds a threshold.
+	 * This is linear in the number of pixels under the parts, rather than sorting
+	 * every depth sample
+	 *
 	 * @param im the color image
 	 * @param depth the depth image (may be of different resolution to the color image)
-	 * @return
+	 * @return the bounding box, or a box of NaNs if there are no valid depths
 	 */
 	Rect3d boundingBox3D(const cv::Mat& im, const cv::Mat& depth) const {
 
@@ -148,7 +157,6 @@ public:
 		cv::Size_<double> dsize  = depth.size();
 		cv::Point_<double> s = cv::Point_<double>(dsize.width / imsize.width, dsize.height / imsize.height);
 
-		cv::Mat_<float> points;
 		std::vector<cv::Rect> boxes;
 		for (size_t n = 0; n < nparts; ++n) {
 			// only keep the intersection of the part with the image frame
@@ -163,32 +171,18 @@ public:
 			r.y = r.y * s.y;
 			r.width  = r.width  * s.x;
 			r.height = r.height * s.y;
-
-			// add the valid points
-			cv::Mat_<float> part = depth(r);
-			if(part.empty())
-				continue;
-
-			for (cv::MatIterator_<float> it = part.begin(); it != part.end(); ++it) {
-				if (*it != 0 && !std::isnan(*it)) points.push_back(*it);
-			}
-
-			if(points.empty())
-			{
-				return Rect3d(std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN(),
-						0, 0, 0);
-			}
-
 		}
 
-		// sort the points
-		std::sort(points.begin(), points.end());
-		cv::resize(points, points, cv::Size(1, 400));
+		// resample the sorted depths under the parts at 400 quantiles
+		const size_t M = 400;
+		cv::Mat_<float> points;
+		if (!depthQuantiles(depth, boxes, M, points)) {
+			return Rect3d(std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN(),
+					0, 0, 0);
+		}
 
 		// get the median of the points
-		const size_t M = points.rows;
 		const size_t midx = M/2;
-		float median = points[midx][0];
 
 		// filter the points
 		cv::Mat_<float> g, dog, dpoints;
@@ -214,6 +208,115 @@ public:
 
 		return Rect3d(tl, br);
 	}
+
+	/*! @brief create the 3D bounding boxes of a set of candidates in parallel
+	 *
+	 * @param candidates the candidates
+	 * @param im the color image
+	 * @param depth the depth image (may be of different resolution to the color image)
+	 * @param boxes the output bounding boxes, one per candidate
+	 */
+	static void boundingBoxes3D(const vectorCandidate& candidates, const cv::Mat& im, const cv::Mat& depth, std::vector<Rect3d>& boxes) {
+		const cv::Mat_<float> depthf = depth;
+		boxes.resize(candidates.size());
+		#ifdef _OPENMP
+		#pragma omp parallel for schedule(dynamic)
+		#endif
+		for (int n = 0; n < (int)candidates.size(); ++n) {
+			boxes[n] = candidates[n].boundingBox3D(im, depthf);
+		}
+	}
+
+	/*! @brief sample the quantiles of the valid depths within a set of regions
+	 *
+	 * Equivalent to sorting the valid (nonzero, non-NaN) depths in every region,
+	 * with repetition where regions overlap, and linearly resampling the sorted
+	 * depths to M samples. The depths are accumulated into a histogram of 1024
+	 * bins between the minimum and maximum depth, so each quantile is within
+	 * about one bin of the exact value
+	 *
+	 * @param depth the depth image
+	 * @param regions the regions of the depth image
+	 * @param M the number of quantiles
+	 * @param points the output M x 1 quantiles, in ascending order
+	 * @return false if there are no valid depths
+	 */
+	static bool depthQuantiles(const cv::Mat_<float>& depth, const std::vector<cv::Rect>& regions, const size_t M, cv::Mat_<float>& points) {
+
+		// the range of the valid depths
+		size_t count = 0;
+		float dmin = std::numeric_limits<float>::max();
+		float dmax = -std::numeric_limits<float>::max();
+		for (size_t n = 0; n < regions.size(); ++n) {
+			const cv::Rect& r = regions[n];
+			for (int y = r.y; y < r.y + r.height; ++y) {
+				const float* row = depth[y];
+				for (int x = r.x; x < r.x + r.width; ++x) {
+					const float d = row[x];
+					if (d == 0 || std::isnan(d)) continue;
+					dmin = std::min(dmin, d);
+					dmax = std::max(dmax, d);
+					count++;
+				}
+			}
+		}
+		if (count == 0) return false;
+
+		// the histogram of the valid depths
+		const int B = 1024;
+		const double width = (dmax > dmin) ? (double)(dmax - dmin) / B : 1.0;
+		std::vector<int> hist(B, 0);
+		for (size_t n = 0; n < regions.size(); ++n) {
+			const cv::Rect& r = regions[n];
+			for (int y = r.y; y < r.y + r.height; ++y) {
+				const float* row = depth[y];
+				for (int x = r.x; x < r.x + r.width; ++x) {
+					const float d = row[x];
+					if (d == 0 || std::isnan(d)) continue;
+					hist[std::min(B-1, (int)((d - dmin) / width))]++;
+				}
+			}
+		}
+
+		// walk the cumulative histogram to find each quantile
+		points.create(M, 1);
+		int b = 0;
+		size_t below = 0;
+		for (size_t m = 0; m < M; ++m) {
+			// the fractional rank of the sample, as resampled by cv::resize()
+			const double rank = std::min(std::max((m + 0.5) * count / M - 0.5, 0.0), count - 1.0);
+			const size_t k0 = rank;
+			const size_t k1 = std::min(k0 + 1, count - 1);
+			const double f  = rank - k0;
+			if (dmax > dmin) {
+				const double v0 = sortedDepth(hist, k0, b, below, dmin, width);
+				int b1 = b;
+				size_t below1 = below;
+				const double v1 = sortedDepth(hist, k1, b1, below1, dmin, width);
+				points(m) = v0 * (1 - f) + v1 * f;
+			} else {
+				points(m) = dmin;
+			}
+		}
+		return true;
+	}
+
+	/*! @brief estimate the k'th smallest depth from a histogram
+	 *
+	 * The samples within a bin are assumed to be evenly spaced
+	 *
+	 * @param hist the depth histogram
+	 * @param k the rank of the depth
+	 * @param b the bin to start searching from, updated to the bin containing k
+	 * @param below the number of samples below bin b, updated with b
+	 * @param dmin the depth of the lower edge of the first bin
+	 * @param width the width of each bin
+	 * @return the estimated depth
+	 */
+	static double sortedDepth(const std::vector<int>& hist, const size_t k, int& b, size_t& below, const float dmin, const double width) {
+		while (below + hist[b] <= k) below += hist[b++];
+		return dmin + (b + (k - below + 0.5) / hist[b]) * width;
+	}
 /*
 
 		const size_t nparts = parts_.size();
@@ -270,6 +373,11 @@ public:
 	 * default value) no overlap is allowed. If, for example, the overlap is
 	 * 0.2, then two candidates' bounding boxes can intersect by 20%
 	 *
+	 * The overlap is the fraction of a candidate's area already covered by
+	 * the union of better candidates. This paints the candidates into a scratch
+	 * image the size of the input, so the overload below, which measures
+	 * pairwise intersection over union, is usually much faster
+	 *
 	 * @param im the input image from which the candidates were found
 	 * @param candidates the vector of candidates
 	 * @param overlap the allowable overlap [0.0 1.0)
@@ -303,6 +411,33 @@ public:
 		candidates.resize(keep);
 	}
 
+	/*! @brief suppress non-maximal candidates by intersection over union
+	 *
+	 * The candidates are sorted from best to worst, and a candidate is kept only
+	 * if the intersection over union of its bounding box with every better kept
+	 * candidate is at most overlap. Only nearby candidates are compared (see
+	 * boxNonMaximaSuppression() in nms.hpp)
+	 *
+	 * @param candidates the vector of candidates, sorted and suppressed in place
+	 * @param overlap the allowable intersection over union [0.0 1.0)
+	 * @param maxdetections the maximum number of candidates to keep. 0 for no limit
+	 */
+	static void nonMaximaSuppression(vectorCandidate& candidates, const float overlap, const size_t maxdetections=0) {
+
+		sort(candidates);
+		const size_t N = candidates.size();
+		std::vector<cv::Rect> boxes(N);
+		for (size_t n = 0; n < N; ++n) boxes[n] = candidates[n].boundingBox();
+
+		// the kept indices are ascending, so the candidates can be compacted in place
+		vectori keep;
+		boxNonMaximaSuppression(boxes, overlap, keep, maxdetections);
+		for (size_t n = 0; n < keep.size(); ++n) {
+			if ((int)n != keep[n]) candidates[n] = candidates[keep[n]];
+		}
+		candidates.resize(keep.size());
+	}
+
 	/*! @brief return a masked representation of a set of candidates
 	 *
 	 * Given a vector of candidates which have already been non-maximally
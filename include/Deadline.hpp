@@ -0,0 +1,76 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    Deadline.hpp
+ *  Created: Oct 19, 2026
+ */
+
+#ifndef DEADLINE_HPP_
+#define DEADLINE_HPP_
+#include <limits>
+#include <opencv2/core/core.hpp>
+
+/*! @class Deadline
+ *  @brief a point in time after which work should be abandoned
+ *
+ *  The stages of the detection pipeline poll the deadline at their cancellation
+ *  points (between pyramid levels, filters and dynamic program components), and
+ *  leave the remaining outputs empty once it has expired. A default constructed
+ *  Deadline never expires
+ */
+class Deadline {
+private:
+	//! the tick count at which the deadline expires, or 0 for never
+	int64 end_;
+public:
+	Deadline() : end_(0) {}
+	/*! @brief a deadline relative to now
+	 *
+	 * @param seconds the time budget, in seconds
+	 */
+	explicit Deadline(double seconds) : end_(cv::getTickCount() + (int64)(seconds * cv::getTickFrequency())) {
+		if (end_ == 0) end_ = 1;
+	}
+	virtual ~Deadline() {}
+	//! true if the deadline can expire
+	bool bounded(void) const { return end_ != 0; }
+	//! true once the deadline has passed
+	bool expired(void) const { return end_ != 0 && cv::getTickCount() >= end_; }
+	//! the time remaining, in seconds (infinite if unbounded, negative once expired)
+	double remaining(void) const {
+		if (end_ == 0) return std::numeric_limits<double>::infinity();
+		return (double)(end_ - cv::getTickCount()) / cv::getTickFrequency();
+	}
+};
+
+#endif /* DEADLINE_HPP_ */
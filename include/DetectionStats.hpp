@@ -0,0 +1,283 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    DetectionStats.hpp
+ *  Created: Oct 19, 2026
+ */
+
+#ifndef DETECTIONSTATS_HPP_
+#define DETECTIONSTATS_HPP_
+#include <algorithm>
+#include <ctime>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "PerfCounters.hpp"
+
+/*! @class DetectionStats
+ *  @brief the timing and counters of a call to detect()
+ *
+ *  Each stage is timed in wall time and in process CPU time. The CPU time
+ *  includes every thread, so its ratio to the wall time is the number of cores
+ *  the stage kept busy. The feature and convolution time of each pyramid level
+ *  is also recorded. The feature time is wall time. The convolution time is
+ *  summed over the threads that convolved the level. The time each thread
+ *  spent in the parallel loops of the features and the convolution is
+ *  recorded too, which separates load imbalance from serial sections
+ *
+ *  A stage costs two clock readings, and a level or filter one each, so the
+ *  statistics are always collected. If PerfCounters are enabled, the hardware
+ *  counts of each stage are also recorded, in total and by thread. The bytes held by the buffers of
+ *  each stage, level and component are accounted in memory
+ */
+class DetectionStats {
+public:
+	//! the stages of the detection pipeline
+	enum Stage { PYRAMID, FEATURES, CONVOLUTION, DP, NMS, ARGMIN, NSTAGES };
+	//! the name of a stage
+	static const char* name(Stage stage) {
+		static const char* const names[NSTAGES] = { "pyramid", "features", "convolution", "dp", "nms", "argmin" };
+		return names[stage];
+	}
+
+	/*! @brief the bytes held by the buffers of a call, by stage, level and component
+	 *
+	 * Each stage accounts the matrices it creates and releases, so the figures
+	 * are the payload of the matrices, without headers or allocator overhead. The
+	 * peaks are taken at those points, so a buffer is counted at its final size.
+	 * The pyramid images, features and part responses are attributed to their
+	 * level, and the working buffers and backtracking maps of the dynamic program
+	 * to their level and component. The working buffers of the convolution engine
+	 * belong to no level
+	 */
+	struct Memory {
+		//! the bytes held now, and at the peak of the call
+		size_t current, peak;
+		//! the bytes held by the buffers of each stage, now and at their peak
+		size_t stage_current[NSTAGES], stage_peak[NSTAGES];
+		//! the bytes held by the buffers of each pyramid level, now and at their peak
+		std::vector<size_t> level_current, level_peak;
+		//! the bytes held by the dynamic program of each component, now and at their peak
+		std::vector<size_t> component_current, component_peak;
+
+		Memory() { clear(); }
+		//! reset the accounts
+		void clear(void) {
+			current = peak = 0;
+			for (int s = 0; s < NSTAGES; ++s) stage_current[s] = stage_peak[s] = 0;
+			level_current.clear();
+			level_peak.clear();
+			component_current.clear();
+			component_peak.clear();
+		}
+		/*! @brief account buffers which have been created. Safe to call from any thread
+		 *
+		 * @param stage the stage which created the buffers
+		 * @param level the pyramid level of the buffers, or -1 for none
+		 * @param component the component of the buffers, or -1 for none
+		 * @param bytes the bytes of the buffers
+		 */
+		void allocate(Stage stage, int level, int component, size_t bytes) {
+			#ifdef _OPENMP
+			#pragma omp critical(memory)
+			#endif
+			{
+				current += bytes;
+				peak = std::max(peak, current);
+				stage_current[stage] += bytes;
+				stage_peak[stage] = std::max(stage_peak[stage], stage_current[stage]);
+				if (level >= 0) add(level_current, level_peak, level, bytes);
+				if (component >= 0) add(component_current, component_peak, component, bytes);
+			}
+		}
+		//! account buffers which have been released, as allocate()
+		void release(Stage stage, int level, int component, size_t bytes) {
+			#ifdef _OPENMP
+			#pragma omp critical(memory)
+			#endif
+			{
+				current -= std::min(current, bytes);
+				stage_current[stage] -= std::min(stage_current[stage], bytes);
+				if (level >= 0 && level < (int)level_current.size()) level_current[level] -= std::min(level_current[level], bytes);
+				if (component >= 0 && component < (int)component_current.size()) component_current[component] -= std::min(component_current[component], bytes);
+			}
+		}
+		//! the bytes of the payload of a matrix
+		static size_t size(const cv::Mat& m) { return m.empty() ? 0 : m.total() * m.elemSize(); }
+		//! the bytes of the payload of nested vectors of matrices
+		template<typename U> static size_t size(const std::vector<U>& v) {
+			size_t total = 0;
+			for (size_t n = 0; n < v.size(); ++n) total += size(v[n]);
+			return total;
+		}
+	private:
+		static void add(std::vector<size_t>& current, std::vector<size_t>& peak, size_t index, size_t bytes) {
+			if (current.size() <= index) {
+				current.resize(index+1, 0);
+				peak.resize(index+1, 0);
+			}
+			current[index] += bytes;
+			peak[index] = std::max(peak[index], current[index]);
+		}
+	};
+
+	DetectionStats() { clear(); }
+	virtual ~DetectionStats() {}
+	//! reset the statistics
+	void clear(void) {
+		for (int s = 0; s < NSTAGES; ++s) {
+			wall[s] = cpu[s] = 0;
+			counters[s] = PerfCounts();
+			thread_counters[s].clear();
+			thread_busy[s].clear();
+		}
+		counted = false;
+		level_features.clear();
+		level_convolution.clear();
+		memory.clear();
+		roots = roots_pruned = 0;
+		levels = filters = candidates = threads = bytes = 0;
+	}
+	//! add the stage times of another call, such as one group of levels of a larger call
+	void addStages(const DetectionStats& other) {
+		for (int s = 0; s < NSTAGES; ++s) {
+			wall[s] += other.wall[s];
+			cpu[s] += other.cpu[s];
+			counters[s] += other.counters[s];
+			PerfCounters::accumulate(thread_counters[s], other.thread_counters[s]);
+			const std::vector<double>& busy = other.thread_busy[s];
+			if (thread_busy[s].size() < busy.size()) thread_busy[s].resize(busy.size(), 0);
+			for (size_t t = 0; t < busy.size(); ++t) thread_busy[s][t] += busy[t];
+		}
+		counted = counted || other.counted;
+		roots += other.roots;
+		roots_pruned += other.roots_pruned;
+	}
+	/*! @brief count the root locations of a scale and component. Safe to call from any thread
+	 *
+	 * @param total the root locations
+	 * @param pruned those of them which were pruned by the dynamic program
+	 */
+	void countRoots(size_t total, size_t pruned) {
+		#ifdef _OPENMP
+		#pragma omp critical(roots)
+		#endif
+		{
+			roots += total;
+			roots_pruned += pruned;
+		}
+	}
+	//! the fraction of the root locations which were pruned
+	double prunedFraction(void) const { return roots ? (double)roots_pruned / roots : 0; }
+	//! the total wall time of the stages, in seconds
+	double totalWall(void) const {
+		double total = 0;
+		for (int s = 0; s < NSTAGES; ++s) total += wall[s];
+		return total;
+	}
+	//! the total CPU time of the stages, in seconds
+	double totalCpu(void) const {
+		double total = 0;
+		for (int s = 0; s < NSTAGES; ++s) total += cpu[s];
+		return total;
+	}
+
+	//! the wall time of each stage, in seconds
+	double wall[NSTAGES];
+	//! the CPU time of each stage across all threads, in seconds
+	double cpu[NSTAGES];
+	//! the hardware counts of each stage across all threads
+	PerfCounts counters[NSTAGES];
+	//! the hardware counts of each stage by thread. Each thread which was alive
+	//! during the stage is listed, whether or not it worked on it
+	std::vector<ThreadPerfCounts> thread_counters[NSTAGES];
+	//! whether the hardware counts were recorded
+	bool counted;
+	//! the time each thread spent in the parallel loops of each stage, in seconds.
+	//! Recorded for the features and the convolution, and empty for the other stages
+	std::vector<double> thread_busy[NSTAGES];
+	//! the wall time of the features of each level, in seconds
+	std::vector<double> level_features;
+	//! the time spent convolving each level, summed over threads, in seconds
+	std::vector<double> level_convolution;
+	//! the number of pyramid levels
+	size_t levels;
+	//! the number of part filters
+	size_t filters;
+	//! the number of detections returned
+	size_t candidates;
+	//! the number of threads available to each stage
+	size_t threads;
+	//! the bytes held by the buffers of the workspace once the call is finished.
+	//! All of them are allocated by a call without a retained workspace
+	size_t bytes;
+	//! the bytes held by the buffers of each stage, level and component
+	Memory memory;
+	//! the root locations of every scale and component of the dynamic program
+	size_t roots;
+	//! the root locations which could not reach the threshold, and were not evaluated
+	size_t roots_pruned;
+};
+
+/*! @class StageTimer
+ *  @brief adds the wall and CPU time of its scope to a stage of DetectionStats
+ */
+class StageTimer {
+private:
+	DetectionStats& stats_;
+	DetectionStats::Stage stage_;
+	int64 wall_;
+	std::clock_t cpu_;
+	std::vector<ThreadPerfCounts> threads_;
+	bool counted_;
+public:
+	StageTimer(DetectionStats& stats, DetectionStats::Stage stage) :
+		stats_(stats), stage_(stage), wall_(cv::getTickCount()), cpu_(std::clock()),
+		counted_(false) {
+		PerfCounts counts;
+		counted_ = PerfCounters::enabled() && PerfCounters::read(counts, &threads_);
+	}
+	~StageTimer() {
+		stats_.wall[stage_] += (double)(cv::getTickCount() - wall_) / cv::getTickFrequency();
+		stats_.cpu[stage_] += (double)(std::clock() - cpu_) / CLOCKS_PER_SEC;
+		PerfCounts end, counts;
+		std::vector<ThreadPerfCounts> threads, delta;
+		if (counted_ && PerfCounters::read(end, &threads)) {
+			PerfCounters::difference(threads_, threads, delta, counts);
+			stats_.counters[stage_] += counts;
+			PerfCounters::accumulate(stats_.thread_counters[stage_], delta);
+			stats_.counted = true;
+		}
+	}
+};
+
+#endif /* DETECTIONSTATS_HPP_ */
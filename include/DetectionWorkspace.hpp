@@ -0,0 +1,129 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    DetectionWorkspace.hpp
+ *  Created: Oct 19, 2026
+ */
+
+#ifndef DETECTIONWORKSPACE_HPP_
+#define DETECTIONWORKSPACE_HPP_
+#include <opencv2/core/core.hpp>
+#include <boost/shared_ptr.hpp>
+#include "DetectionStats.hpp"
+#include "DynamicProgram.hpp"
+#include "IConvolutionEngine.hpp"
+#include "SearchSpacePruning.hpp"
+#include "types.hpp"
+
+/*! @class DetectionWorkspace
+ *  @brief the buffers of every stage of the detection pipeline
+ *
+ *  Each stage of PartsBasedDetector::detect() writes into the buffers of a
+ *  workspace with cv::Mat::create(), which only allocates when the size or type
+ *  of a buffer changes. For a fixed image size, such as the frames of a camera,
+ *  a workspace kept between calls makes every frame after the first reuse the
+ *  pyramid images, features, part responses, dynamic program buffers, root
+ *  suppression masks and backtracking maps of the previous frame instead of allocating them again.
+ *  PartsBasedDetector::prepare() allocates the buffers ahead of the first frame
+ *
+ *  A workspace holds the intermediate scores of every scale and component of the
+ *  dynamic program, which are otherwise released as soon as each component is
+ *  finished, so it trades peak memory for allocations. A workspace which does
+ *  not retain them is used internally for one-off detections
+ *
+ *  A workspace must not be shared by concurrent calls to detect(). Use one per
+ *  thread, with a single detector shared between them
+ */
+class DetectionWorkspace {
+private:
+	//! keep the working buffers of the dynamic program between calls
+	bool retain_;
+	static size_t bytes(const cv::Mat& m) { return m.empty() ? 0 : m.total() * m.elemSize(); }
+	static size_t bytes(const ComponentBuffers& b) {
+		return bytes(b.scores) + bytes(b.messages) + bytes(b.dt) + bytes(b.Ixdt) + bytes(b.Iydt) + bytes(b.rootv) + bytes(b.rooti) +
+			bytes(b.mask) + bytes(b.reachable);
+	}
+	template<typename U> static size_t bytes(const std::vector<U>& v) {
+		size_t total = 0;
+		for (size_t n = 0; n < v.size(); ++n) total += bytes(v[n]);
+		return total;
+	}
+public:
+	explicit DetectionWorkspace(bool retain = true) : retain_(retain) {}
+	virtual ~DetectionWorkspace() {}
+	//! whether the working buffers of the dynamic program are kept between calls
+	bool retain(void) const { return retain_; }
+	//! release all of the buffers
+	void clear(void) { *this = DetectionWorkspace(retain_); }
+	/*! @brief the bytes held by the buffers of the workspace
+	 *
+	 * Headers which alias other buffers, such as the part scores of the leaves,
+	 * and the root scores when they are held by the dynamic program buffers, are
+	 * not counted
+	 */
+	size_t bytes(void) const {
+		return bytes(pyraimages) + bytes(features) + bytes(features_scratch) + bytes(pdf) + bytes(quantized) +
+			bytes(Ix) + bytes(Iy) + bytes(Ik) + bytes(dp) + (retain_ ? 0 : bytes(rootv) + bytes(rooti)) +
+			bytes(nms.over) + bytes(nms.maxima) + bytes(nms.neighbours);
+	}
+
+	//! the timing and counters of the last call to detect() with this workspace
+	DetectionStats stats;
+
+	//! the images of the pyramid, fine to coarse
+	vectorMat pyraimages;
+	//! the size of a feature cell at each level of the pyramid, in pixels of the image
+	vectorf scales;
+	//! the features of each level of the pyramid
+	vectorMat features;
+	//! the working buffers of the features of each level
+	vector2DMat features_scratch;
+	//! the responses of each filter at each level
+	vector2DMat pdf;
+	//! the working buffers of the convolution engine, created on first use
+	boost::shared_ptr<IConvolutionEngine::Workspace> convolution;
+	//! the responses, quantized for the fixed point dynamic program
+	vector2DMat quantized;
+	//! the backtracking maps of the dynamic program
+	vector4DMat Ix, Iy, Ik;
+	//! the root scores and mixtures of each level and component
+	vector2DMat rootv, rooti;
+	//! the working buffers of the dynamic program for each level and component
+	vector2DComponentBuffers dp;
+	//! the depth of the tree evaluated at each level
+	vectori maxdepth;
+	//! the working buffers of root suppression
+	SuppressionBuffers nms;
+};
+
+#endif /* DETECTIONWORKSPACE_HPP_ */
@@ -0,0 +1,162 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    Detections.hpp
+ *  Created: Oct 19, 2026
+ */
+
+#ifndef DETECTIONS_HPP_
+#define DETECTIONS_HPP_
+#include <vector>
+#include <algorithm>
+#include <opencv2/core/core.hpp>
+#include "Candidate.hpp"
+#include "types.hpp"
+
+/*! @class Detections
+ *  @brief a structure-of-arrays buffer of detections
+ *
+ *  Each Candidate owns two heap allocated vectors, so building thousands of
+ *  them during backtracking is dominated by allocation. Detections instead
+ *  stores flat arrays of the root score, component and pyramid level of each
+ *  detection, and a single block of part rectangles, with nparts consecutive
+ *  rectangles per detection (the root first). Detections can be appended to
+ *  one another, so independent buffers can be filled without locking and
+ *  merged once. toCandidates() provides the vectorCandidate view of the output
+ */
+class Detections {
+private:
+	//! the root score of each detection
+	vectorf score_;
+	//! the model component of each detection
+	vectori component_;
+	//! the pyramid level of each detection
+	vectori level_;
+	//! the offset of each detection's parts into parts_
+	vectori offset_;
+	//! the bounding boxes of the parts of all detections
+	std::vector<cv::Rect> parts_;
+	//! the pyramid levels which were fully searched
+	std::vector<bool> covered_;
+public:
+	Detections() : offset_(1, 0) {}
+	virtual ~Detections() {}
+	//! the number of detections
+	size_t size(void) const { return score_.size(); }
+	//! true if there are no detections
+	bool empty(void) const { return score_.empty(); }
+	//! the root score of detection i
+	float score(size_t i) const { return score_[i]; }
+	//! the model component of detection i
+	int component(size_t i) const { return component_[i]; }
+	//! the pyramid level of detection i
+	int level(size_t i) const { return level_[i]; }
+	//! the number of parts of detection i
+	size_t nparts(size_t i) const { return offset_[i+1] - offset_[i]; }
+	//! the bounding boxes of the parts of detection i, the root first
+	const cv::Rect* parts(size_t i) const { return &parts_[offset_[i]]; }
+	//! reserve space for n detections of nparts parts
+	void reserve(size_t n, size_t nparts) {
+		score_.reserve(n); component_.reserve(n); level_.reserve(n);
+		offset_.reserve(n+1); parts_.reserve(n*nparts);
+	}
+	//! remove all detections, keeping the allocated storage
+	void clear(void) {
+		score_.clear(); component_.clear(); level_.clear(); parts_.clear();
+		offset_.resize(1);
+		covered_.clear();
+	}
+	/*! @brief the pyramid levels which were fully searched
+	 *
+	 * Only set by searches which may be cut short by a deadline. Empty otherwise
+	 */
+	const std::vector<bool>& covered(void) const { return covered_; }
+	void setCovered(const std::vector<bool>& covered) { covered_ = covered; }
+	//! true unless a search was cut short before every pyramid level was searched
+	bool complete(void) const { return std::find(covered_.begin(), covered_.end(), false) == covered_.end(); }
+
+	/*! @brief add a detection
+	 *
+	 * @param score the root score
+	 * @param component the model component
+	 * @param level the pyramid level
+	 * @param parts the bounding boxes of the parts, the root first
+	 * @param nparts the number of parts
+	 */
+	void push_back(float score, int component, int level, const cv::Rect* parts, size_t nparts) {
+		score_.push_back(score);
+		component_.push_back(component);
+		level_.push_back(level);
+		parts_.insert(parts_.end(), parts, parts + nparts);
+		offset_.push_back(parts_.size());
+	}
+
+	/*! @brief append another set of detections to the end of this one
+	 *
+	 * @param other the detections to append
+	 */
+	void append(const Detections& other) {
+		const int base = parts_.size();
+		score_.insert(score_.end(), other.score_.begin(), other.score_.end());
+		component_.insert(component_.end(), other.component_.begin(), other.component_.end());
+		level_.insert(level_.end(), other.level_.begin(), other.level_.end());
+		parts_.insert(parts_.end(), other.parts_.begin(), other.parts_.end());
+		for (size_t i = 1; i < other.offset_.size(); ++i) offset_.push_back(base + other.offset_[i]);
+	}
+
+	/*! @brief convert detection i to a Candidate
+	 *
+	 * @param i the detection
+	 * @return the candidate, with the root score on the root part and 0 on the others
+	 */
+	Candidate candidate(size_t i) const {
+		Candidate candidate;
+		candidate.setComponent(component_[i]);
+		const cv::Rect* rects = parts(i);
+		for (size_t p = 0; p < nparts(i); ++p) {
+			candidate.addPart(rects[p], p == 0 ? score_[i] : 0.0);
+		}
+		return candidate;
+	}
+
+	/*! @brief append all detections to a vector of Candidates
+	 *
+	 * @param candidates the output candidates
+	 */
+	void toCandidates(vectorCandidate& candidates) const {
+		candidates.reserve(candidates.size() + size());
+		for (size_t i = 0; i < size(); ++i) candidates.push_back(candidate(i));
+	}
+};
+
+#endif /* DETECTIONS_HPP_ */
@@ -108,6 +108,15 @@ public:
 // DECLARATION
 // ---------------------------------------------------------------------------
 
+/*! @brief the precision of the lower envelope boundaries
+ *
+ * The boundaries between parabolas of the lower envelope are fractional and
+ * must be able to represent +/- infinity, so integer (fixed point) scores use
+ * double precision boundaries
+ */
+template<typename T> struct EnvelopeBoundary { typedef T type; };
+template<> struct EnvelopeBoundary<int> { typedef double type; };
+
 /*! @class DistanceTransform
  *
  *  @brief class for performing distance transforms of sampled functions
@@ -123,7 +132,8 @@ public:
 template<typename T>
 class DistanceTransform {
 private:
-	inline void computeRow(T const * const src, T * const dst, int * const ptr, const size_t N, const PenaltyFunction& f, int os=0) const;
+	typedef typename EnvelopeBoundary<T>::type B;
+	inline void computeRow(T const * const src, T * const dst, int * const ptr, int * const v, B * const z, const size_t N, const PenaltyFunction& f, int os=0) const;
 public:
 	DistanceTransform() {}
 	virtual ~DistanceTransform() {}
@@ -139,26 +149,26 @@ public:
  *
  * This method performs the 1D distance transform across the rows of a matrix.
  * It is called twice internally by distanceTransform(), once across the rows
- * and once down the columns (transposed to rows)
+ * and once down the columns
  *
  * @param src pointer to the start of the source data
  * @param dst pointer to the start of the destination data
  * @param ptr pointer to the indices
+ * @param v working storage for the locations of the parabolas (at least N)
+ * @param z working storage for the boundaries between the parabolas (at least N+1)
  * @param N the total number of rows
  * @param f the 1D distance penalty function
  * @param os the anchor offset
  */
 template<typename T>
-inline void DistanceTransform<T>::computeRow(T const * const src, T * const dst, int * const ptr, const size_t N, const PenaltyFunction& f, int os) const {
+inline void DistanceTransform<T>::computeRow(T const * const src, T * const dst, int * const ptr, int * const v, B * const z, const size_t N, const PenaltyFunction& f, int os) const {
 
-	int * const v = new int[N];
-	T   * const z = new T[N+1];
 	int k = 0;
 	v[0] = 0;
-	z[0] = -std::numeric_limits<T>::infinity();
-	z[1] = +std::numeric_limits<T>::infinity();
+	z[0] = -std::numeric_limits<B>::infinity();
+	z[1] = +std::numeric_limits<B>::infinity();
 	for (size_t q = 1; q < N; ++q) {
-		T s = f(v[k], q, src[v[k]], src[q]);
+		B s = f(v[k], q, src[v[k]], src[q]);
 		while (s <= z[k] && k > 0) {
 			k--;
 			s = f(v[k], q, src[v[k]], src[q]);
@@ -166,19 +176,16 @@ inline void DistanceTransform<T>::computeRow(T const * const src, T * const dst,
 		k++;
 		v[k]   = q;
 		z[k]   = s;
-		z[k+1] = +std::numeric_limits<T>::infinity();
+		z[k+1] = +std::numeric_limits<B>::infinity();
 	}
 
 	k = 0;
 	for (size_t q = 0; q < N; ++q) {
 		while (z[k+1] < os) k++;
-		dst[q] = f(os-v[k], src[v[k]]);
+		dst[q] = cv::saturate_cast<T>(f(os-v[k], src[v[k]]));
 		ptr[q] = v[k];
 		os++;
 	}
-
-	delete [] v;
-	delete [] z;
 }
 
 /*! @brief Generalized distance transform
@@ -191,6 +198,10 @@ inline void DistanceTransform<T>::computeRow(T const * const src, T * const dst,
  * of the cost functions are quadratic. The 2D distance transform is broken down
  * into two 1D transforms since the operation is separable
  *
+ * The outputs are only reallocated if their size or type changes, and the columns
+ * are transformed through a single row of working storage rather than transposed
+ * copies, so repeated transforms of the same size do not allocate matrices
+ *
  * @param score_in the input score
  * @param fx the distance penalty function in the x-dimension
  * @param fy the distance penalty function in the y-dimension
@@ -205,41 +216,33 @@ void DistanceTransform<T>::compute(const cv::Mat_<T>& score_in, const PenaltyFun
 	// get the dimensionality of the score
 	const size_t M = score_in.rows;
 	const size_t N = score_in.cols;
+	const size_t L = std::max(M, N);
 
-	// allocate the output and working matrices
-	score_out.create(cv::Size(M, N));
+	// allocate the output matrices and the working storage
+	score_out.create(cv::Size(N, M));
 	Ix.create(cv::Size(N, M));
-	Iy.create(cv::Size(M, N));
-	cv::Mat_<T> score_tmp(cv::Size(N, M));
+	Iy.create(cv::Size(N, M));
+	cv::AutoBuffer<int> v(L);
+	cv::AutoBuffer<B> z(L+1);
+	cv::AutoBuffer<T> col_in(M), col_out(M);
+	cv::AutoBuffer<int> col_ptr(L), col_ix(M);
 
 	// compute the distance transform across the rows
 	for (size_t m = 0; m < M; ++m) {
-		computeRow(score_in[m], score_tmp[m], Ix[m], N, fx, os.x);
+		computeRow(score_in[m], score_out[m], Ix[m], v, z, N, fx, os.x);
 	}
 
-	// transpose the intermediate matrices
-	transpose(score_tmp, score_tmp);
-
-	// compute the distance transform down the columns
+	// compute the distance transform down the columns. The argmin of each
+	// output is the row chosen by the column pass, and the column chosen by
+	// the row pass at that row
 	for (size_t n = 0; n < N; ++n) {
-		computeRow(score_tmp[n], score_out[n], Iy[n], M, fy, os.y);
-	}
-
-	// transpose back to the original layout
-	transpose(score_out, score_out);
-	transpose(Iy, Iy);
-
-	// get argmins
-	cv::Mat_<int> row(cv::Size(N, 1));
-	int * const row_ptr = row[0];
-	for (size_t m = 0; m < M; ++m) {
-		int * const Iy_ptr = Iy[m];
-		int * const Ix_ptr = Ix[m];
-		for (size_t n = 0; n < N; ++n) {
-			row_ptr[n] = Iy_ptr[Ix_ptr[n]];
-		}
-		for (size_t n = 0; n < N; ++n) {
-			Iy_ptr[n] = row_ptr[n];
+		for (size_t m = 0; m < M; ++m) col_in[m] = score_out(m,n);
+		computeRow(col_in, col_out, col_ptr, v, z, M, fy, os.y);
+		for (size_t m = 0; m < M; ++m) col_ix[m] = Ix(col_ptr[m],n);
+		for (size_t m = 0; m < M; ++m) {
+			score_out(m,n) = col_out[m];
+			Ix(m,n) = col_ix[m];
+			Iy(m,n) = col_ptr[m];
 		}
 	}
 }
@@ -41,12 +41,38 @@
 #include <vector>
 #include <opencv2/core/core.hpp>
 #include "Candidate.hpp"
+#include "Detections.hpp"
+#include "Deadline.hpp"
+#include "DetectionStats.hpp"
 #include "DistanceTransform.hpp"
 #include "Model.hpp"
 #include "Parts.hpp"
+#include "PartsPlan.hpp"
 #include "types.hpp"
 
 
+/*! @brief the working buffers of the dynamic program for one scale and component
+ *
+ * The buffers are only reallocated if the size of the scale changes, so keeping
+ * them between calls to DynamicProgram::min() avoids allocating the scores,
+ * messages and distance transforms of every part for each image
+ */
+struct ComponentBuffers {
+	//! the accumulated scores of each mixture of each part
+	vector2DMat scores;
+	//! headers onto the accumulated scores, or onto the appearance of leaf parts
+	vector2DMat partscores;
+	//! the message passed from each part to each of its parent's mixtures
+	vector2DMat messages;
+	//! the distance transform of each mixture of each part, and its arguments
+	vector2DMat dt, Ixdt, Iydt;
+	//! the root scores and mixtures
+	cv::Mat rootv, rooti;
+	//! the root locations which could reach the threshold, of all mixtures and of one
+	cv::Mat mask, reachable;
+};
+typedef std::vector<std::vector<ComponentBuffers> > vector2DComponentBuffers;
+
 /*! @class DynamicProgram
  *  @brief Dynamic Program to calculate the best holistic detection
  *
@@ -57,22 +83,50 @@
  *  min() computes the best candidates by passing messages from the leaves
  *  of the Part tree to the root. argmin() traverses back down the tree to
  *  retrieve the actual Part locations
+ *
+ *  min() is parallelized as a task graph per scale and component, so it
+ *  requires OpenMP 3.0 task support when built with OpenMP
+ *
+ *  DynamicProgram<int> runs in fixed point. The scores passed to min() and
+ *  the plan (see PartsPlan::quantize()) must be pre-multiplied by the scale.
+ *  The threshold is given in unscaled units, and the candidate scores
+ *  returned by argmin() are divided by the scale
  */
 template<typename T>
 class DynamicProgram {
 private:
 	//! the threshold for a positive detection
 	double thresh_;
+	//! skip the components, root mixtures and root locations which can never reach the threshold
+	bool prune_;
+	//! the fixed point scale of the scores (1 for floating point)
+	double scale_;
 	DistanceTransform<T> dt_;
 	void distanceTransform1D(const T* src, T* dst, int* ptr, size_t n, T a, T b, int os);
 	void distanceTransform1DMat(const cv::Mat_<T>& src, cv::Mat_<T>& dst, cv::Mat_<int>& ptr, size_t N, T a, T b, int os);
+	bool minScales(const PartsPlan& plan, vector2DMat& scores, vector4DMat& Ix, vector4DMat& Iy, vector4DMat& Ik, vector2DMat& rootv, vector2DMat& rooti, vector2DComponentBuffers* buffers, const vectori& maxdepth, const Deadline& deadline, DetectionStats* stats) const;
+	void minComponent(const ComponentPlan& plan, int maxdepth, vectorMat& scores, vector2DMat& Ix, vector2DMat& Iy, vector2DMat& Ik, cv::Mat& rootv, cv::Mat& rooti, ComponentBuffers& buffers, DetectionStats* stats) const;
+	void minSubtree(const ComponentPlan& plan, int p, int maxdepth, const std::vector<bool>& viable, vectorMat& scores, ComponentBuffers& buffers, vector2DMat& Ix, vector2DMat& Iy, vector2DMat& Ik) const;
+	void upperBound(const ComponentPlan& plan, int p, int maxdepth, vectorMat& scores, std::vector<double>& bound, double& magnitude) const;
+	void messageBound(const ComponentPlan& plan, int p, int maxdepth, vectorMat& scores, std::vector<double>& bound, double& magnitude) const;
+	void message(const ComponentPlan& plan, int p, const std::vector<bool>& viable, ComponentBuffers& buffers, vectorMat& Ix, vectorMat& Iy, vectorMat& Ik) const;
 public:
-	DynamicProgram() {}
-	DynamicProgram(double thresh) : thresh_(thresh) {}
+	DynamicProgram() : thresh_(0), prune_(true), scale_(1) {}
+	DynamicProgram(double thresh, bool prune = true, double scale = 1) : thresh_(thresh), prune_(prune), scale_(scale) {}
 	virtual ~DynamicProgram() {}
+	// get and set methods
+	//! the threshold for a positive detection
+	double thresh(void) const { return thresh_; }
+	//! enable or disable upper bound pruning. The output is identical either way
+	void setPruning(bool prune) { prune_ = prune; }
+	bool pruning(void) const { return prune_; }
+	//! the fixed point scale of the scores
+	double scale(void) const { return scale_; }
 	// public methods
-	void min(Parts& parts, vector2DMat& scores, vector4DMat& Ix, vector4DMat& Iy, vector4DMat& Ik, vector2DMat& rootv, vector2DMat& rooti);
-	void argmin(Parts& parts, const vector2DMat& rootv, const vector2DMat& rooti, const vectorf scales, const vector4DMat& Ix, const vector4DMat& Iy, const vector4DMat& Ik, vectorCandidate& candidates);
+	bool min(const PartsPlan& plan, vector2DMat& scores, vector4DMat& Ix, vector4DMat& Iy, vector4DMat& Ik, vector2DMat& rootv, vector2DMat& rooti, const vectori& maxdepth = vectori(), const Deadline& deadline = Deadline(), DetectionStats* stats = NULL) const;
+	bool min(const PartsPlan& plan, vector2DMat& scores, vector4DMat& Ix, vector4DMat& Iy, vector4DMat& Ik, vector2DMat& rootv, vector2DMat& rooti, vector2DComponentBuffers& buffers, const vectori& maxdepth = vectori(), const Deadline& deadline = Deadline(), DetectionStats* stats = NULL) const;
+	void argmin(const PartsPlan& plan, const vector2DMat& rootv, const vector2DMat& rooti, const vectorf scales, const vector4DMat& Ix, const vector4DMat& Iy, const vector4DMat& Ik, Detections& detections, const vectori& maxdepth = vectori()) const;
+	void argmin(const PartsPlan& plan, const vector2DMat& rootv, const vector2DMat& rooti, const vectorf scales, const vector4DMat& Ix, const vector4DMat& Iy, const vector4DMat& Ik, vectorCandidate& candidates, const vectori& maxdepth = vectori()) const;
 	void distanceTransform(const cv::Mat& score_in, const vectorf w, cv::Point os, cv::Mat& score_out, cv::Mat& Ix, cv::Mat& Iy);
 };
 
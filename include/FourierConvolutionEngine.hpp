@@ -51,12 +51,25 @@ private:
 	size_t flen_;
 	//! the internal representation of the filters
   vector2DMat filters_;
-  void convolve(const cv::Mat& feature, vectorMat& filter, cv::Mat& pdf, const size_t channels);
+  //! the size of each filter, before padding
+  std::vector<cv::Size> sizes_;
+  //! the split features and per thread spectra of a call to pdf()
+  class Workspace : public IConvolutionEngine::Workspace {
+  public:
+    //! the features at each scale, split into one plane per channel
+    vector2DMat planes;
+    //! a pair of spectra per thread
+    vectorMat spectra;
+    virtual size_t bytes(void) const;
+  };
+  void convolve(const vectorMat& featurevec, const vectorMat& filter, const cv::Size& ksize, cv::Mat& pdf, cv::Mat& temp, cv::Mat& padded) const;
 public:
 	FourierConvolutionEngine(const cv::Size& size, int type, size_t flen);
 	virtual ~FourierConvolutionEngine();
 	virtual void setFilters(const vectorMat& filters);
-	virtual void pdf(const vectorMat& features, vector2DMat& responses);
+	virtual IConvolutionEngine::Workspace* createWorkspace(void) const;
+	using IConvolutionEngine::pdf;
+	virtual void pdf(const vectorMat& features, vector2DMat& responses, IConvolutionEngine::Workspace& workspace, const Deadline& deadline = Deadline()) const;
 };
 
 #endif /* FOURIER_CONVOLUTION_ENGINE_HPP_ */
@@ -53,14 +53,12 @@ class HOGFeatures : public IFeatures {
 private:
 	//! the spatial binning size
 	size_t binsize_;
-	//! the number of scales to compute features at
+	//! the number of scales per octave to compute features at
 	size_t nscales_;
 	//! the length of the feature at each bin (histogram size)
 	size_t flen_;
 	//! the number of orientations to bin
 	size_t norient_;
-	//! the scales of the features
-	vectorf scales_;
 	//! the scaling factor between successive levels in the pyramid
 	float sfactor_;
 	//! the interval between half resolution scales
@@ -68,7 +66,7 @@ private:
 
 	// private methods
 	void boundaryOcclusionFeature(cv::Mat& feature, const int flen, const int padsize);
-	template<typename IT> void features(const cv::Mat& im, cv::Mat& feature) const;
+	template<typename IT> void features(const cv::Mat& im, cv::Mat& feature, cv::Mat& hist, cv::Mat& norm) const;
 public:
 	HOGFeatures() {}
 	HOGFeatures(size_t binsize, size_t nscales, size_t flen, size_t norient) :
@@ -83,8 +81,10 @@ public:
 	// get methods
 	size_t binsize(void) const { return binsize_; }
 	size_t nscales(void) const { return nscales_; }
-	vectorf scales(void) const { return scales_; }
-	void pyramid(const cv::Mat& im, vectorMat& pyrafeatures);
+	void pyramid(const cv::Mat& im, vectorMat& pyrafeatures, vectorf& scales, const Deadline& deadline = Deadline()) const;
+	void scalePyramid(const cv::Mat& im, vectorMat& pyraimages, vectorf& scales) const;
+	using IFeatures::levelFeatures;
+	void levelFeatures(const cv::Mat& im, cv::Mat& feature, vectorMat& scratch) const;
 };
 
 #endif /* HOGFEATURES_HPP_ */
@@ -39,21 +39,83 @@
 #ifndef ICONVOLUTIONENGINE_HPP_
 #define ICONVOLUTIONENGINE_HPP_
 
+#include <boost/scoped_ptr.hpp>
+#include "Deadline.hpp"
 #include "types.hpp"
 
+/*! @class IConvolutionEngine
+ *  @brief Interface for convolving a feature pyramid with the part filters
+ *
+ *  The filters are fixed by setFilters(). Everything pdf() writes to lives in a
+ *  Workspace, so pdf() may be called from any number of threads concurrently,
+ *  provided each uses its own workspace
+ */
 class IConvolutionEngine {
 public:
+	/*! @brief implementation specific working buffers of pdf()
+	 *
+	 * A workspace is created by createWorkspace() of the engine it is used with
+	 */
+	class Workspace {
+	public:
+		virtual ~Workspace() {}
+		//! the bytes held by the working buffers, excluding any internal state of the engine
+		virtual size_t bytes(void) const { return 0; }
+		//! the time spent convolving each level in the last call, summed over threads, in seconds
+		std::vector<double> level_seconds;
+		//! the time each thread spent convolving in the last call, in seconds
+		std::vector<double> thread_seconds;
+	};
+
 	virtual ~IConvolutionEngine() {}
 
+	//! create an empty workspace for pdf()
+	virtual Workspace* createWorkspace(void) const = 0;
+
 	/*! @brief probability density function
 	 *
 	 * A custom convolution-type operation for producing a map of probability density functions
 	 * where each pixel indicates the likelihood of a positive detection
+	 *
+	 * Empty levels of the feature pyramid produce empty responses. If the deadline
+	 * expires before every filter has been applied at a level, all of the responses
+	 * of that level are left empty
+	 *
+	 * The responses and the workspace are only reallocated if the size of a
+	 * level changes, so they can be reused across images of the same size
+	 *
+	 * @param features the input pyramid of features
+	 * @param responses a 2D vector of pdfs, 1st dimension across scale, 2nd dimension across filter
+	 * @param workspace the working buffers, from createWorkspace()
+	 * @param deadline the deadline after which no more filters are applied
+	 */
+	virtual void pdf(const vectorMat& features, vector2DMat& responses, Workspace& workspace, const Deadline& deadline = Deadline()) const = 0;
+
+	/*! @brief probability density function
 	 *
 	 * @param features the input pyramid of features
 	 * @param responses a 2D vector of pdfs, 1st dimension across scale, 2nd dimension across filter
+	 * @param deadline the deadline after which no more filters are applied
+	 */
+	void pdf(const vectorMat& features, vector2DMat& responses, const Deadline& deadline = Deadline()) const {
+		boost::scoped_ptr<Workspace> workspace(createWorkspace());
+		pdf(features, responses, *workspace, deadline);
+	}
+
+	/*! @brief empty the levels of a set of responses which are incomplete
+	 *
+	 * @param responses a 2D vector of pdfs, 1st dimension across scale, 2nd dimension across filter
 	 */
-	virtual void pdf(const vectorMat& features, vector2DMat& responses) = 0;
+	static void discardIncomplete(vector2DMat& responses) {
+		for (size_t m = 0; m < responses.size(); ++m) {
+			for (size_t n = 0; n < responses[m].size(); ++n) {
+				if (responses[m][n].empty()) {
+					responses[m].assign(responses[m].size(), cv::Mat());
+					break;
+				}
+			}
+		}
+	}
 
 	/*! @brief set the convolve engine filters
 	 *
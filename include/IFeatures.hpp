@@ -40,11 +40,15 @@
 #define FEATURES_HPP_
 #include <vector>
 #include <opencv2/core/core.hpp>
+#include "Deadline.hpp"
 #include "types.hpp"
 
 /*! @class Feature interface
  *  @brief Interface for creating and comparing image features
  * IFeatures provides an interface for creating and comparing image features
+ *
+ * Implementations hold no per-image state, so the const methods may be called
+ * from any number of threads concurrently
  */
 class IFeatures {
 public:
@@ -52,24 +56,49 @@ public:
 	// get and set methods
 	//! retrieve the spatial binning size (1 if not relevant)
 	virtual size_t binsize(void) const = 0;
-	//! retrieve the number of scales the features are calculated over
+	//! retrieve the number of scales per octave the features are calculated over
 	virtual size_t nscales(void) const = 0;
 	// public methods
-	/*! @brief the vector of scales
-	 *
-	 * the vector of scales, 1 indicating the native image resolution,
-	 * values lower than 1 indicating downsampled images, and values greater
-	 * than 1 indicating hallucinated resolutions
-	 */
-	virtual vectorf scales(void) const = 0;
-
 	/*! @brief a pyramid of features
 	 *
 	 * features calculated of a number of scales
 	 * @param im the input image to calculate features for
 	 * @param pyrafeatures an output vector of matrices of features, one matrix for each scale
+	 * @param scales the output scale of each level, the size of a feature cell in
+	 * pixels of the input image
+	 * @param deadline the levels which have not been started when the deadline expires are left empty
+	 */
+	virtual void pyramid(const cv::Mat& im, vectorMat& pyrafeatures, vectorf& scales, const Deadline& deadline = Deadline()) const = 0;
+
+	/*! @brief the pyramid of images that features are calculated from
+	 *
+	 * Together with levelFeatures(), this allows the features of each level
+	 * to be calculated on demand
+	 * @param im the input image
+	 * @param pyraimages an output vector of images, one for each scale
+	 * @param scales the output scale of each level, as for pyramid()
+	 */
+	virtual void scalePyramid(const cv::Mat& im, vectorMat& pyraimages, vectorf& scales) const = 0;
+
+	/*! @brief the features of a single level of the pyramid
+	 *
+	 * The output and the scratch buffers are only reallocated if the size of the
+	 * level changes, so they can be reused across images of the same size
+	 * @param im the image of the level, from scalePyramid()
+	 * @param feature the output features
+	 * @param scratch implementation specific working buffers for the level
+	 */
+	virtual void levelFeatures(const cv::Mat& im, cv::Mat& feature, vectorMat& scratch) const = 0;
+
+	/*! @brief the features of a single level of the pyramid
+	 *
+	 * @param im the image of the level, from scalePyramid()
+	 * @param feature the output features
 	 */
-	virtual void pyramid(const cv::Mat& im, vectorMat& pyrafeatures) = 0;
+	void levelFeatures(const cv::Mat& im, cv::Mat& feature) const {
+		vectorMat scratch;
+		levelFeatures(im, feature, scratch);
+	}
 };
 
 //IFeatures::~IFeatures() {}
@@ -54,6 +54,19 @@ private:
 public:
 	virtual ~Math() {}
 
+	/*! @brief the lowest score of a given precision
+	 *
+	 * For floating point types this is -infinity. Integer (fixed point) types
+	 * have no infinity, so half of the lowest representable value is used, which
+	 * leaves headroom for a bias or message to be added without overflow
+	 *
+	 * @return the lowest score
+	 */
+	template<typename T>
+	static T lowest(void) {
+		return std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::min() / 2;
+	}
+
 	/*! @brief return the median value of a matrix
 	 *
 	 * @param mat the input matrix
@@ -122,7 +135,7 @@ public:
 		// perform the indexing
 		size_t M = in[0].rows;
 		size_t N = in[0].cols;
-		std::vector<const T*> in_ptr(K);
+		cv::AutoBuffer<const T*> in_ptr(K);
 		if (in[0].isContinuous()) { N = M*N; M = 1; }
 		for (size_t m = 0; m < M; ++m) {
 			T* out_ptr = out.ptr<T>(m);
@@ -168,14 +181,14 @@ public:
 		size_t M = in[0].rows;
 		size_t N = in[0].cols;
 
-		std::vector<const T*> in_ptr(K);
+		cv::AutoBuffer<const T*> in_ptr(K);
 		if (in[0].isContinuous()) { N = M*N; M = 1; }
 		for (size_t m = 0; m < M; ++m) {
 			T* maxv_ptr = maxv.ptr<T>(m);
 			int* maxi_ptr = maxi.ptr<int>(m);
 			for (size_t k = 0; k < K; ++k) in_ptr[k] = in[k].ptr<T>(m);
 			for (size_t n = 0; n < N; ++n) {
-				T v = -std::numeric_limits<T>::infinity();
+				T v = lowest<T>();
 				int i = 0;
 				for (size_t k = 0; k < K; ++k) if (in_ptr[k][n] > v) { i = k; v = in_ptr[k][n]; }
 				maxi_ptr[n] = i;
@@ -184,6 +197,62 @@ public:
 		}
 	}
 
+	/*! @brief Reduce a vector of biased matrices via elementwise max
+	 *
+	 * Equivalent to adding bias[k*stride] to in[k] before calling reduceMax(),
+	 * without allocating the biased intermediates
+	 *
+	 * @param in the input 3D matrix
+	 * @param bias the bias of each matrix in the input
+	 * @param stride the stride between elements of bias
+	 * @param maxv the output 2D matrix, containing the maximal values
+	 * @param maxi the output 2D matrix, containing the maximal indices
+	 * @param mask the elements to reduce, of type CV_8U (optional). The others are
+	 * set to the lowest value and index 0
+	 */
+	template<typename T>
+	static void reduceMax(const vectorMat& in, const float* bias, size_t stride, cv::Mat& maxv, cv::Mat& maxi, const cv::Mat& mask = cv::Mat()) {
+
+		// error checking
+		const size_t K = in.size();
+		assert (K > 0);
+		for (size_t k = 1; k < K; ++k) assert(in[k].size() == in[k-1].size());
+
+		// allocate the output matrices
+		maxv.create(in[0].size(), in[0].type());
+		maxi.create(in[0].size(), cv::DataType<int>::type);
+
+		size_t M = in[0].rows;
+		size_t N = in[0].cols;
+
+		cv::AutoBuffer<const T*> in_ptr(K);
+		cv::AutoBuffer<T> b(K);
+		for (size_t k = 0; k < K; ++k) b[k] = cv::saturate_cast<T>(bias[k*stride]);
+		const bool masked = !mask.empty();
+		if (in[0].isContinuous() && (!masked || mask.isContinuous())) { N = M*N; M = 1; }
+		for (size_t m = 0; m < M; ++m) {
+			T* maxv_ptr = maxv.ptr<T>(m);
+			int* maxi_ptr = maxi.ptr<int>(m);
+			const uchar* mask_ptr = masked ? mask.ptr<uchar>(m) : NULL;
+			for (size_t k = 0; k < K; ++k) in_ptr[k] = in[k].ptr<T>(m);
+			for (size_t n = 0; n < N; ++n) {
+				T v = lowest<T>();
+				int i = 0;
+				if (mask_ptr && !mask_ptr[n]) {
+					maxi_ptr[n] = i;
+					maxv_ptr[n] = v;
+					continue;
+				}
+				for (size_t k = 0; k < K; ++k) {
+					const T vk = in_ptr[k][n] + b[k];
+					if (vk > v) { i = k; v = vk; }
+				}
+				maxi_ptr[n] = i;
+				maxv_ptr[n] = v;
+			}
+		}
+	}
+
 };
 
 
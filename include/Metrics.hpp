@@ -39,13 +39,241 @@
 #ifndef METRICS_HPP_
 #define METRICS_HPP_
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
 #include <opencv2/core/core.hpp>
+
+/*! @brief the ground truth of an object: the location of each keypoint, its box and its scale */
+struct Annotation {
+	std::vector<cv::Point2f> points;
+	cv::Rect box;
+	//! the normalizing scale of distances to the keypoints, usually max(box.width, box.height)
+	double scale;
+};
+
+/*! @brief a detection: the location of each keypoint, its box and its score */
+struct KeypointDetection {
+	std::vector<cv::Point2f> points;
+	cv::Rect box;
+	float score;
+};
+
+typedef std::vector<std::vector<Annotation> > DatasetAnnotations;
+typedef std::vector<std::vector<KeypointDetection> > DatasetDetections;
+
+/*! @class Metrics
+ *  @brief accuracy metrics of pose estimation and detection
+ *
+ *  Ports of matlab/evaluation: PCK (eval_pck.m), the average precision of
+ *  keypoints, APK (eval_apk.m), and the VOC average precision (VOCap.m),
+ *  the latter also over boxes. Datasets are indexed by image, then by object
+ */
 class Metrics {
 private:
-	cv::Mat camera_matrix;
-	std::vector<>
+	Metrics() {}
+	/*! @brief the average precision of detections already marked as true or false positives
+	 *
+	 * @param scored the score and true positive flag of each detection, in any order
+	 * @param npositive the number of ground truth objects
+	 */
+	static double ap(std::vector<std::pair<float, bool> >& scored, size_t npositive) {
+		std::sort(scored.begin(), scored.end(), descending);
+		std::vector<double> recall(scored.size()), precision(scored.size());
+		size_t tp = 0;
+		for (size_t n = 0; n < scored.size(); ++n) {
+			if (scored[n].second) tp++;
+			recall[n] = npositive ? (double)tp / npositive : 0;
+			precision[n] = (double)tp / (n+1);
+		}
+		return ap(recall, precision);
+	}
+	static bool descending(const std::pair<float, bool>& a, const std::pair<float, bool>& b) { return a.first > b.first; }
+public:
+	virtual ~Metrics() {}
 
-};
+	/*! @brief the intersection over union of two boxes */
+	static double overlap(const cv::Rect& a, const cv::Rect& b) {
+		const double intersection = (a & b).area();
+		const double area = a.area() + b.area() - intersection;
+		return area > 0 ? intersection / area : 0;
+	}
 
+	/*! @brief the VOC average precision: the area under the monotone precision envelope
+	 *
+	 * @param recall the recall at each rank, in descending order of score
+	 * @param precision the precision at each rank
+	 * @return the average precision
+	 */
+	static double ap(const std::vector<double>& recall, const std::vector<double>& precision) {
+		std::vector<double> mrec(1, 0.0), mpre(1, 0.0);
+		mrec.insert(mrec.end(), recall.begin(), recall.end());
+		mpre.insert(mpre.end(), precision.begin(), precision.end());
+		mrec.push_back(1.0);
+		mpre.push_back(0.0);
+		for (int i = (int)mpre.size()-2; i >= 0; --i) mpre[i] = std::max(mpre[i], mpre[i+1]);
+		double ap = 0;
+		for (size_t i = 1; i < mrec.size(); ++i) {
+			if (mrec[i] != mrec[i-1]) ap += (mrec[i] - mrec[i-1]) * mpre[i];
+		}
+		return ap;
+	}
+
+	/*! @brief the percentage of correct keypoints
+	 *
+	 * Each ground truth object is paired with the highest scoring detection in its
+	 * image whose box overlaps it by at least half. A keypoint is correct if it is
+	 * within thresh * scale of the ground truth. Objects without a detection count
+	 * all of their keypoints as incorrect. Unlike eval_pck.m, each object is
+	 * normalized by its own scale rather than that of the last object
+	 *
+	 * @param detections the detections of each image
+	 * @param truth the ground truth of each image
+	 * @param thresh the distance threshold, as a fraction of the scale
+	 * @return the fraction of correct keypoints, per keypoint
+	 */
+	static std::vector<double> pck(const DatasetDetections& detections, const DatasetAnnotations& truth, double thresh = 0.5) {
+		size_t nkeypoints = 0;
+		for (size_t i = 0; i < truth.size(); ++i) {
+			for (size_t j = 0; j < truth[i].size(); ++j) nkeypoints = std::max(nkeypoints, truth[i][j].points.size());
+		}
+		std::vector<double> correct(nkeypoints, 0);
+		size_t nobjects = 0;
+		for (size_t i = 0; i < truth.size(); ++i) {
+			for (size_t j = 0; j < truth[i].size(); ++j) {
+				const Annotation& gt = truth[i][j];
+				nobjects++;
+				const KeypointDetection* best = NULL;
+				for (size_t d = 0; i < detections.size() && d < detections[i].size(); ++d) {
+					const KeypointDetection& det = detections[i][d];
+					if (overlap(gt.box, det.box) < 0.5) continue;
+					if (!best || det.score > best->score) best = &det;
+				}
+				if (!best) continue;
+				for (size_t k = 0; k < gt.points.size() && k < best->points.size(); ++k) {
+					const cv::Point2f d = best->points[k] - gt.points[k];
+					if (sqrt(d.dot(d)) < thresh * gt.scale) correct[k]++;
+				}
+			}
+		}
+		for (size_t k = 0; k < nkeypoints; ++k) correct[k] = nobjects ? correct[k] / nobjects : 0;
+		return correct;
+	}
+
+	/*! @brief the average precision of a keypoint
+	 *
+	 * Detections are ranked by score across the dataset. Each is a true positive if
+	 * its keypoint is within thresh * scale of the nearest keypoint of an object in
+	 * its image which has not already been claimed by a higher scoring detection
+	 *
+	 * @param detections the detections of each image
+	 * @param truth the ground truth of each image
+	 * @param keypoint the keypoint to evaluate
+	 * @param thresh the distance threshold, as a fraction of the scale
+	 * @return the average precision
+	 */
+	static double apk(const DatasetDetections& detections, const DatasetAnnotations& truth, size_t keypoint, double thresh = 0.5) {
+		std::vector<std::pair<size_t, size_t> > ranked;
+		for (size_t i = 0; i < detections.size(); ++i) {
+			for (size_t d = 0; d < detections[i].size(); ++d) ranked.push_back(std::make_pair(i, d));
+		}
+		std::sort(ranked.begin(), ranked.end(), RankByScore(detections));
+
+		size_t npositive = 0;
+		std::vector<std::vector<bool> > claimed(truth.size());
+		for (size_t i = 0; i < truth.size(); ++i) {
+			npositive += truth[i].size();
+			claimed[i].resize(truth[i].size(), false);
+		}
+		std::vector<std::pair<float, bool> > scored(ranked.size());
+		for (size_t n = 0; n < ranked.size(); ++n) {
+			const size_t i = ranked[n].first;
+			const KeypointDetection& det = detections[i][ranked[n].second];
+			scored[n] = std::make_pair(det.score, false);
+			if (i >= truth.size() || keypoint >= det.points.size()) continue;
+			double nearest = std::numeric_limits<double>::infinity();
+			int j = -1;
+			for (size_t g = 0; g < truth[i].size(); ++g) {
+				if (keypoint >= truth[i][g].points.size()) continue;
+				const cv::Point2f d = det.points[keypoint] - truth[i][g].points[keypoint];
+				const double distance = sqrt(d.dot(d)) / truth[i][g].scale;
+				if (distance < nearest) { nearest = distance; j = g; }
+			}
+			if (j >= 0 && nearest <= thresh && !claimed[i][j]) {
+				claimed[i][j] = true;
+				scored[n].second = true;
+			}
+		}
+		return ap(scored, npositive);
+	}
+
+	/*! @brief the average precision of every keypoint, evaluated in parallel */
+	static std::vector<double> apk(const DatasetDetections& detections, const DatasetAnnotations& truth, double thresh = 0.5) {
+		size_t nkeypoints = 0;
+		for (size_t i = 0; i < truth.size(); ++i) {
+			for (size_t j = 0; j < truth[i].size(); ++j) nkeypoints = std::max(nkeypoints, truth[i][j].points.size());
+		}
+		std::vector<double> aps(nkeypoints, 0);
+		#ifdef _OPENMP
+		#pragma omp parallel for schedule(dynamic)
+		#endif
+		for (int k = 0; k < (int)nkeypoints; ++k) aps[k] = apk(detections, truth, k, thresh);
+		return aps;
+	}
+
+	/*! @brief the VOC average precision of the detected boxes
+	 *
+	 * Detections are ranked by score across the dataset. Each is a true positive if
+	 * it overlaps an unclaimed object of its image by at least the given overlap
+	 *
+	 * @param detections the detections of each image
+	 * @param truth the ground truth of each image
+	 * @param minoverlap the minimum intersection over union of a true positive
+	 * @return the average precision
+	 */
+	static double voc(const DatasetDetections& detections, const DatasetAnnotations& truth, double minoverlap = 0.5) {
+		std::vector<std::pair<size_t, size_t> > ranked;
+		for (size_t i = 0; i < detections.size(); ++i) {
+			for (size_t d = 0; d < detections[i].size(); ++d) ranked.push_back(std::make_pair(i, d));
+		}
+		std::sort(ranked.begin(), ranked.end(), RankByScore(detections));
+
+		size_t npositive = 0;
+		std::vector<std::vector<bool> > claimed(truth.size());
+		for (size_t i = 0; i < truth.size(); ++i) {
+			npositive += truth[i].size();
+			claimed[i].resize(truth[i].size(), false);
+		}
+		std::vector<std::pair<float, bool> > scored(ranked.size());
+		for (size_t n = 0; n < ranked.size(); ++n) {
+			const size_t i = ranked[n].first;
+			const KeypointDetection& det = detections[i][ranked[n].second];
+			scored[n] = std::make_pair(det.score, false);
+			if (i >= truth.size()) continue;
+			double best = 0;
+			int j = -1;
+			for (size_t g = 0; g < truth[i].size(); ++g) {
+				const double o = overlap(det.box, truth[i][g].box);
+				if (o > best) { best = o; j = g; }
+			}
+			if (j >= 0 && best >= minoverlap && !claimed[i][j]) {
+				claimed[i][j] = true;
+				scored[n].second = true;
+			}
+		}
+		return ap(scored, npositive);
+	}
+
+private:
+	/*! @brief orders (image, detection) indices by descending detection score */
+	struct RankByScore {
+		const DatasetDetections& detections;
+		explicit RankByScore(const DatasetDetections& d) : detections(d) {}
+		bool operator()(const std::pair<size_t, size_t>& a, const std::pair<size_t, size_t>& b) const {
+			return detections[a.first][a.second].score > detections[b.first][b.second].score;
+		}
+	};
+};
 
 #endif /* METRICS_HPP_ */
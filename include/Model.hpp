@@ -113,6 +113,10 @@ public:
 	float thresh(void) const { return thresh_; }
 	int binsize(void) const { return binsize_; }
 	int nscales(void) const { return nscales_; }
+	/*! @brief override the detection threshold. Takes effect at the next distributeModel() */
+	void setThresh(float thresh) { thresh_ = thresh; }
+	/*! @brief override the levels per octave of the pyramid. Takes effect at the next distributeModel() */
+	void setNScales(int nscales) { nscales_ = nscales; }
 	int flen(void) const { return flen_; }
 	int norient(void) const { return norient_; }
 	int ncomponents(void) const { return filterid_.size(); }
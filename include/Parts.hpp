@@ -168,6 +168,8 @@ public:
 	}
 	//! the part's filter index
 	int filteri(size_t mixture = 0) const { return (*filtersi_)[(*filterid_)[self_][mixture]]; }
+	//! the part's index into the filters (and by extension, the scores)
+	int filterid(size_t mixture = 0) const { return (*filterid_)[self_][mixture]; }
 	//! the part's bias
 	vectorf bias(size_t mixture = 0) const {
 		const int offset = (*biasid_)[self_][mixture];
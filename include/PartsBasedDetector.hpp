@@ -42,14 +42,23 @@
 #include <vector>
 #include <opencv2/core/core.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 #include "Parts.hpp"
+#include "PartsPlan.hpp"
 #include "Model.hpp"
 #include "Candidate.hpp"
+#include "Deadline.hpp"
+#include "Detections.hpp"
+#include "DetectionStats.hpp"
+#include "DetectionWorkspace.hpp"
 #include "IFeatures.hpp"
 #include "IConvolutionEngine.hpp"
 #include "DynamicProgram.hpp"
 #include "SearchSpacePruning.hpp"
 
+template<typename T> class VideoDetector;
+
 /*! @mainpage PartsBasedDetector
  *
  * PartsBasedDetector is a visual object recognition technique described in the
@@ -146,6 +155,10 @@
  * method distributeModel() for setting up the detector parameters from a deserialized
  * model, and a method detect() for running the detection pipeline.
  *
+ * Once the model has been distributed and the options set, detect() does not modify
+ * the detector, so a single detector may serve any number of threads concurrently.
+ * Each thread passes its own DetectionWorkspace, or uses the overloads without one
+ *
  * @tparam T the detector precision. Should be one of float or double. On modern 64-bit
  * machines, the latter will likely be just as fast.
  */
@@ -162,15 +175,116 @@ private:
 	DynamicProgram<T> dp_;
 	//! the tree of Parts
 	Parts parts_;
+	//! the tree of Parts, compiled for the dynamic program
+	PartsPlan plan_;
 	//! the search space pruner
 	SearchSpacePruning<T> ssp_;
+	//! the window (in root cells) for local maxima suppression of the root scores
+	int nms_window_;
+	//! the maximum number of root locations to backtrack across all scales and components
+	size_t topk_;
+	//! the detection height (in pixels) below which the reduced tree is evaluated
+	int reduced_height_;
+	//! the depth of the reduced tree
+	int reduced_depth_;
+	//! run the dynamic program in fixed point
+	bool fixed_point_;
+	//! the fixed point dynamic program
+	DynamicProgram<int> fixed_dp_;
+	//! the tree of Parts, quantized for the fixed point dynamic program
+	PartsPlan fixed_plan_;
+	//! the order in which to process the pyramid levels when detecting within a deadline
+	vectori level_order_;
+	//! the number of pyramid levels to process at a time when streaming (0 disables streaming)
+	size_t stream_levels_;
+	//! convolution workspaces released by detections without a workspace of their own
+	mutable std::vector<boost::shared_ptr<IConvolutionEngine::Workspace> > convolution_pool_;
+	//! guards the pool of convolution workspaces
+	mutable boost::mutex convolution_mutex_;
+	boost::shared_ptr<IConvolutionEngine::Workspace> acquireConvolution(void) const;
+	void releaseConvolution(boost::shared_ptr<IConvolutionEngine::Workspace>& workspace) const;
+	void stream(const cv::Mat& im, Detections& detections, DetectionStats& stats) const;
+	void count(const DetectionWorkspace& workspace, size_t candidates, DetectionStats& stats) const;
+	void reducedDepths(const vectorf& scales, vectori& maxdepth) const;
+	void levelOrder(size_t nscales, vectori& order) const;
+	void responses(const cv::Mat& im, DetectionWorkspace& workspace) const;
+	void featurePyramid(const cv::Mat& im, DetectionWorkspace& workspace) const;
+	void convolve(DetectionWorkspace& workspace) const;
+	void minimize(DetectionWorkspace& workspace) const;
+	void backtrack(DetectionWorkspace& workspace, Detections& detections) const;
+	static void quantize(const vector2DMat& pdf, vector2DMat& quantized, double scale);
+	bool respond(vector2DMat& pdf, DetectionWorkspace& workspace, Detections& detections, const Deadline& deadline) const;
+	template<typename S> bool solve(const DynamicProgram<S>& dp, const PartsPlan& plan, vector2DMat& pdf, DetectionWorkspace& workspace, Detections& detections, const Deadline& deadline) const;
+	template<typename S> bool minimize(const DynamicProgram<S>& dp, const PartsPlan& plan, vector2DMat& pdf, DetectionWorkspace& workspace, const Deadline& deadline) const;
+	template<typename S> void backtrack(const DynamicProgram<S>& dp, const PartsPlan& plan, DetectionWorkspace& workspace, Detections& detections) const;
+	//! runs the stages of detect() on separate threads
+	friend class VideoDetector<T>;
+	template<typename S> void solveBatch(const DynamicProgram<S>& dp, const PartsPlan& plan, vector2DMat& pdf, DetectionWorkspace& workspace, const std::vector<size_t>& offsets, std::vector<Detections>& detections) const;
 public:
-	PartsBasedDetector() {}
+	PartsBasedDetector() : nms_window_(0), topk_(0), reduced_height_(0), reduced_depth_(0), fixed_point_(false), fixed_dp_(0, true, 4096), stream_levels_(0) {}
 	virtual ~PartsBasedDetector() {}
 	// public methods
 	const std::string& name(void) const { return name_; }
-	void detect(const cv::Mat& im, std::vector<Candidate>& candidates);
-	void detect(const cv::Mat& im, const cv::Mat& depth, std::vector<Candidate>& candidates);
+	/*! @brief suppress the root scores before backtracking
+	 *
+	 * Only root locations which are local maxima within a window, and which are within the
+	 * best topk across all scales and components, are backtracked into candidates.
+	 * Both are disabled (0) by default. When detecting within a deadline, the levels are
+	 * suppressed one at a time, so topk bounds the candidates of each level (up to
+	 * topk per level in all). When streaming, it bounds those of each group of levels
+	 *
+	 * @param window the local maxima window, in root cells. 0 disables local suppression
+	 * @param topk the maximum number of candidates. 0 for no limit
+	 */
+	void setRootSuppression(int window, size_t topk) { nms_window_ = window; topk_ = topk; }
+	/*! @brief evaluate a reduced tree for small detections
+	 *
+	 * At the pyramid levels where the root of the model is less than height pixels tall
+	 * in the input image, only the parts up to the given depth in the tree are evaluated.
+	 * The deeper parts are placed at their anchors when backtracking. The root scores at
+	 * those levels exclude the deeper parts, so the accuracy impact should be calibrated
+	 * on a validation set (see ReducedTreeCalibration). Disabled (0) by default
+	 *
+	 * @param height the detection height in pixels. 0 always evaluates the full tree
+	 * @param depth the depth of the reduced tree (the root has depth 0)
+	 */
+	void setReducedTree(int height, int depth) { reduced_height_ = height; reduced_depth_ = depth; }
+	void setFixedPoint(bool enable, double scale = 4096);
+	/*! @brief prune the messages of the dynamic program
+	 *
+	 * Pruning is exact (see DynamicProgram::setPruning()), so this only exists to
+	 * measure its effect. distributeModel() resets it to enabled, so call it afterwards
+	 */
+	void setPruning(bool prune) { dp_.setPruning(prune); fixed_dp_.setPruning(prune); }
+	//! whether the dynamic program runs in fixed point
+	bool fixedPoint(void) const { return fixed_point_; }
+	/*! @brief the order in which to process the pyramid levels when detecting within a deadline
+	 *
+	 * @param order the pyramid levels (0 is the finest), most productive first, for
+	 * example learned from the levels at which detections are usually found. Levels
+	 * which are not listed are processed afterwards, coarsest first
+	 */
+	void setLevelOrder(const vectori& order) { level_order_ = order; }
+	/*! @brief stream the pyramid through the detector a few levels at a time
+	 *
+	 * Each group of levels is taken from features through to backtracking, and its
+	 * features, part responses and dynamic program buffers are released before the
+	 * next group is started. Peak memory is then roughly that of one group rather
+	 * than the whole pyramid. Root suppression (setRootSuppression()) is applied per
+	 * group, so topk bounds the candidates of each group. Disabled (0) by default
+	 *
+	 * @param levels the number of pyramid levels per group. 0 processes the whole pyramid at once
+	 */
+	void setStreaming(size_t levels) { stream_levels_ = levels; }
+	void detect(const cv::Mat& im, std::vector<Candidate>& candidates) const;
+	void detect(const cv::Mat& im, const cv::Mat& depth, std::vector<Candidate>& candidates) const;
+	void detect(const cv::Mat& im, const cv::Mat& depth, Detections& detections) const;
+	void detect(const cv::Mat& im, Detections& detections, DetectionStats& stats) const;
+	void detect(const cv::Mat& im, const Deadline& deadline, Detections& detections) const;
+	void detect(const cv::Mat& im, DetectionWorkspace& workspace, Detections& detections) const;
+	void detect(const vectorMat& images, std::vector<vectorCandidate>& candidates) const;
+	void detect(const vectorMat& images, std::vector<Detections>& detections) const;
+	void prepare(DetectionWorkspace& workspace, const cv::Size& size) const;
 	void distributeModel(Model& model);
 };
 
@@ -0,0 +1,142 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    PartsPlan.hpp
+ *  Created: Oct 19, 2026
+ */
+
+#ifndef PARTSPLAN_HPP_
+#define PARTSPLAN_HPP_
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "Parts.hpp"
+#include "types.hpp"
+
+/*! @class ComponentPlan
+ *  @brief a flattened, read-only execution plan for a single component
+ *
+ *  ComponentPart resolves every access through several levels of indirection
+ *  (filterid_, biasid_, defid_, parentid_), and returns the bias and deformation
+ *  weights by value. ComponentPlan resolves all of the indexing once, when the
+ *  model is distributed, into contiguous arrays. Part-mixtures are numbered
+ *  consecutively, so mixture m of part p is stored at mixoffset(p)+m
+ */
+class ComponentPlan {
+private:
+	//! the parent of each part (the root is its own parent)
+	vectori parent_;
+	//! the depth of each part in the tree (the root has depth 0)
+	vectori depth_;
+	//! the offset of each part's children into children_
+	vectori childoffset_;
+	//! the children of each part, in descending order
+	vectori children_;
+	//! the offset of each part's mixtures
+	vectori mixoffset_;
+	//! the filter (score) index of each part-mixture
+	vectori filter_;
+	//! the deformation weights of each part-mixture, 4 per part-mixture
+	vectorf defw_;
+	//! the anchor of each part-mixture relative to its parent
+	vectorPoint anchor_;
+	//! the size of each part-mixture's filter
+	std::vector<cv::Size> size_;
+	//! the offset of each part's bias matrix into bias_
+	vectori biasoffset_;
+	//! the bias of each (child mixture, parent mixture) pair, row-major per part
+	vectorf bias_;
+	//! the bias of the root
+	float rootbias_;
+public:
+	ComponentPlan() : rootbias_(0) {}
+	ComponentPlan(Parts& parts, size_t c);
+	virtual ~ComponentPlan() {}
+	//! the number of parts in the component
+	size_t nparts(void) const { return parent_.size(); }
+	//! the parent of part p
+	int parent(int p) const { return parent_[p]; }
+	//! the depth of part p in the tree
+	int depth(int p) const { return depth_[p]; }
+	//! the number of children of part p
+	size_t nchildren(int p) const { return childoffset_[p+1] - childoffset_[p]; }
+	//! the i'th child of part p, in descending order
+	int child(int p, size_t i) const { return children_[childoffset_[p] + i]; }
+	//! the number of mixtures of part p
+	size_t nmixtures(int p) const { return mixoffset_[p+1] - mixoffset_[p]; }
+	//! the flat index of mixture m of part p
+	int mixoffset(int p, size_t m = 0) const { return mixoffset_[p] + m; }
+	//! the filter (score) index of mixture m of part p
+	int filter(int p, size_t m = 0) const { return filter_[mixoffset_[p] + m]; }
+	//! the 4 deformation weights of mixture m of part p
+	const float* defw(int p, size_t m = 0) const { return &defw_[4*(mixoffset_[p] + m)]; }
+	//! the anchor of mixture m of part p relative to its parent
+	const cv::Point& anchor(int p, size_t m = 0) const { return anchor_[mixoffset_[p] + m]; }
+	//! the filter size of mixture m of part p
+	const cv::Size& size(int p, size_t m = 0) const { return size_[mixoffset_[p] + m]; }
+	/*! @brief the bias of child mixtures of part p, for parent mixture m
+	 *
+	 * @return a pointer to the bias of child mixture 0. The bias of child
+	 * mixture mm is found at a stride of biasstride(p)
+	 */
+	const float* bias(int p, size_t m = 0) const { return &bias_[biasoffset_[p] + m]; }
+	//! the stride between child mixtures in bias()
+	size_t biasstride(int p) const { return nmixtures(parent_[p]); }
+	//! the bias of the root
+	float rootBias(void) const { return rootbias_; }
+	void quantize(double scale);
+};
+
+/*! @class PartsPlan
+ *  @brief the execution plans for all components of a Parts tree
+ *
+ *  The plan is compiled once by PartsBasedDetector::distributeModel(), and is
+ *  consumed directly by the DynamicProgram so that no indexing or allocation is
+ *  performed per part-mixture at detection time
+ */
+class PartsPlan {
+private:
+	std::vector<ComponentPlan> components_;
+public:
+	PartsPlan() {}
+	PartsPlan(Parts& parts);
+	virtual ~PartsPlan() {}
+	//! the number of components in the model
+	size_t ncomponents(void) const { return components_.size(); }
+	//! the plan of component c
+	const ComponentPlan& component(size_t c) const { return components_[c]; }
+	//! the number of parts within component c
+	size_t nparts(size_t c) const { return components_[c].nparts(); }
+	PartsPlan quantized(double scale) const;
+};
+
+#endif /* PARTSPLAN_HPP_ */
@@ -0,0 +1,123 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    PerfCounters.hpp
+ *  Created: Oct 19, 2026
+ */
+
+#ifndef PERFCOUNTERS_HPP_
+#define PERFCOUNTERS_HPP_
+#include <cstddef>
+#include <vector>
+
+/*! @brief hardware event counts
+ *
+ * The counts are scaled by the fraction of time each counter was scheduled,
+ * so they are estimates if the kernel had to multiplex the counters
+ */
+struct PerfCounts {
+	PerfCounts() : cycles(0), instructions(0), llc_misses(0), branch_misses(0) {}
+	//! CPU cycles
+	double cycles;
+	//! instructions retired
+	double instructions;
+	//! last level cache misses. Each one is roughly a cache line (64 bytes) of memory traffic
+	double llc_misses;
+	//! mispredicted branches
+	double branch_misses;
+	//! instructions per cycle
+	double ipc(void) const { return cycles > 0 ? instructions / cycles : 0; }
+	//! the memory traffic implied by the cache misses, in bytes
+	double bytes(void) const { return llc_misses * 64; }
+	PerfCounts& operator+=(const PerfCounts& other) {
+		cycles += other.cycles; instructions += other.instructions;
+		llc_misses += other.llc_misses; branch_misses += other.branch_misses;
+		return *this;
+	}
+	PerfCounts& operator-=(const PerfCounts& other) {
+		cycles -= other.cycles; instructions -= other.instructions;
+		llc_misses -= other.llc_misses; branch_misses -= other.branch_misses;
+		return *this;
+	}
+};
+
+/*! @brief the hardware event counts of one thread
+ *
+ * The kernel reuses the ids of threads which have exited, so a thread is
+ * identified by its id together with its start time
+ */
+struct ThreadPerfCounts {
+	ThreadPerfCounts() : tid(0), start(0) {}
+	//! the kernel id of the thread
+	long tid;
+	//! the start time of the thread, in clock ticks since boot
+	unsigned long long start;
+	//! the counts of the thread
+	PerfCounts counts;
+	//! whether two counts belong to the same thread
+	bool same(const ThreadPerfCounts& other) const { return tid == other.tid && start == other.start; }
+};
+
+/*! @class PerfCounters
+ *  @brief hardware performance counters of every thread of the process
+ *
+ *  On Linux, the counters are read through perf_event_open(2). Each thread of the
+ *  process has its own counters, opened the first time it is seen in
+ *  /proc/self/task. The counters of threads which have exited are closed, and
+ *  those of a thread id which has been reused by a new thread are reopened.
+ *  read() reports each thread and their sum. Once enabled, each stage timed by
+ *  DetectionStats reads them before and after, so the counts of a stage include
+ *  all of the threads which worked on it (and any other work the process did
+ *  meanwhile, such as concurrent detections). The work of a thread which exits
+ *  during a stage is not counted
+ *
+ *  Reading the counters of every thread costs a few system calls per thread,
+ *  so unlike the timing, they are disabled by default
+ *
+ *  Where perf events are unavailable (other platforms, containers without the
+ *  perf_event_open system call, or a restrictive perf_event_paranoid) enable()
+ *  returns false and the counts stay at zero. A counter which is not supported
+ *  by the CPU, such as the cache misses of some virtual machines, reads zero
+ */
+class PerfCounters {
+public:
+	static bool available(void);
+	static bool enable(bool enable);
+	static bool enabled(void);
+	static bool read(PerfCounts& counts, std::vector<ThreadPerfCounts>* per_thread = NULL);
+	static void difference(const std::vector<ThreadPerfCounts>& before, const std::vector<ThreadPerfCounts>& after,
+			std::vector<ThreadPerfCounts>& delta, PerfCounts& total);
+	static void accumulate(std::vector<ThreadPerfCounts>& into, const std::vector<ThreadPerfCounts>& from);
+};
+
+#endif /* PERFCOUNTERS_HPP_ */
@@ -70,11 +70,14 @@ void PointCloudClusterer<PointType>::computeBoundingBoxes(
 	bounding_boxes.resize(candidates.size(), Rect3d(0, 0, 0, 0, 0, 0));
 	parts_centers.resize(candidates.size());
 
+	std::vector<Rect3d> cubes;
+	Candidate::boundingBoxes3D(candidates, rgb, depth, cubes);
+
 	for (size_t i = 0; i < candidates.size(); ++i)
 	{
 		const Candidate& candidate = candidates[i];
 
-		const Rect3d cube = candidate.boundingBox3D(rgb, depth);
+		const Rect3d& cube = cubes[i];
 		cv::Point3d tl, br;
 
 		if (isnan(cube.x) || isnan(cube.y) || isnan(cube.z) || isnan(cube.width)
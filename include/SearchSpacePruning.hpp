@@ -45,6 +45,16 @@
 #include "Parts.hpp"
 #include "types.hpp"
 
+/*! @brief the working buffers of root suppression, for each scale and component */
+struct SuppressionBuffers {
+	//! the root locations above the threshold, and then those which are suppressed
+	vector2DMat over;
+	//! the root locations which survive suppression
+	vector2DMat maxima;
+	//! the neighbourhood masks of local maxima suppression
+	vector2DMat neighbours;
+};
+
 /*
  *
  */
@@ -55,6 +65,8 @@ public:
 	virtual ~SearchSpacePruning() {}
 	void filterResponseByDepth(vector2DMat& pdfs, const std::vector<cv::Size>& fsizes, const cv::Mat& depth, const vectorf& scales, const float X, const float fx);
 	void filterCandidatesByDepth(Parts& parts, vectorCandidate& candidates, const cv::Mat& depth, const float zfactor);
+	void nonMaxSuppression(vector2DMat& rootv, const double thresh, const int window, const size_t topk) const;
+	void nonMaxSuppression(vector2DMat& rootv, const double thresh, const int window, const size_t topk, SuppressionBuffers& buffers) const;
 };
 
 #endif /* SEARCHSPACEPRUNING_HPP_ */
@@ -39,6 +39,7 @@
 #ifndef SPATIAL_CONVOLUTION_ENGINE_HPP_
 #define SPATIAL_CONVOLUTION_ENGINE_HPP_
 
+#include <boost/shared_ptr.hpp>
 #include "IConvolutionEngine.hpp"
 
 class SpatialConvolutionEngine: public IConvolutionEngine {
@@ -47,14 +48,32 @@ private:
 	int type_;
 	//! the number of layers to each filter
 	size_t flen_;
-	//! the internal representation of the filters
-	vector2DFilterEngine filters_;
-	void convolve(const cv::Mat& feature, vectorFilterEngine& filter, cv::Mat& pdf, const size_t stride);
+	//! the filters, split into one plane per channel. Replaced rather than modified
+	//! by setFilters(), so that workspaces can tell which filters they were built from
+	boost::shared_ptr<const vector2DMat> filters_;
+	//! the filter engines, split features and per thread responses of a call to pdf()
+	class Workspace : public IConvolutionEngine::Workspace {
+	public:
+		//! the filters the filter engines were created from
+		boost::shared_ptr<const vector2DMat> source;
+		//! a filter engine for each plane of each filter. Filter engines are stateful,
+		//! so each workspace has its own
+		vector2DFilterEngine filters;
+		//! the features at each scale, split into one plane per channel
+		vector2DMat planes;
+		//! the response of a single plane, per thread, at each scale
+		vector2DMat partial;
+		virtual size_t bytes(void) const;
+	};
+	void createFilterEngines(Workspace& workspace) const;
+	void convolve(const vectorMat& featurev, vectorFilterEngine& filter, cv::Mat& pdf, cv::Mat& pdfc) const;
 public:
 	SpatialConvolutionEngine(int type, size_t flen);
 	virtual ~SpatialConvolutionEngine();
 	virtual void setFilters(const vectorMat& filters);
-	virtual void pdf(const vectorMat& features, vector2DMat& responses);
+	virtual IConvolutionEngine::Workspace* createWorkspace(void) const;
+	using IConvolutionEngine::pdf;
+	virtual void pdf(const vectorMat& features, vector2DMat& responses, IConvolutionEngine::Workspace& workspace, const Deadline& deadline = Deadline()) const;
 };
 
 #endif /* SPATIAL_CONVOLUTION_ENGINE_HPP_ */
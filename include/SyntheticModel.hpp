@@ -0,0 +1,128 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    SyntheticModel.hpp
+ *  Created: Oct 19, 2026
+ */
+
+#ifndef SYNTHETICMODEL_HPP_
+#define SYNTHETICMODEL_HPP_
+
+#include <string>
+#include "FileStorageModel.hpp"
+
+/*! @class SyntheticModel
+ *  @brief a random but structurally valid model
+ *
+ *  SyntheticModel generates a model with the shape of a trained model
+ *  (components, parts, mixtures, filter sizes, tree topology, binsize and
+ *  interval) but random weights. It exercises exactly the same code paths,
+ *  and costs the same to evaluate, as a trained model of that shape, so it
+ *  can stand in for one when benchmarking and testing. The model serializes
+ *  through FileStorageModel, to .xml or .yaml
+ */
+class SyntheticModel: public FileStorageModel {
+public:
+	//! the topology of the tree of parts within each component
+	enum Tree {
+		//! every part is a child of the root
+		STAR,
+		//! each part is a child of the previous part
+		CHAIN,
+		//! a complete binary tree, in breadth first order
+		BINARY,
+		//! each part is a child of a uniformly chosen earlier part
+		RANDOM
+	};
+
+	/*! @brief the shape of the model to generate */
+	struct Parameters {
+		Parameters() : name("synthetic"), ncomponents(1), nparts(26), nmixtures(1),
+				rootsize(5,5), partsize(5,5), tree(RANDOM), binsize(4), interval(5),
+				flen(32), norient(18), thresh(-1.0f), seed(0) {}
+		//! the name of the model
+		std::string name;
+		//! the number of components
+		int ncomponents;
+		//! the number of parts in each component
+		int nparts;
+		//! the number of mixtures of each part
+		int nmixtures;
+		//! the size of the root filters, in cells
+		cv::Size rootsize;
+		//! the size of the remaining part filters, in cells
+		cv::Size partsize;
+		//! the topology of the tree of parts
+		Tree tree;
+		//! the spatial pooling size of the features, in pixels
+		int binsize;
+		//! the number of levels per octave of the pyramid
+		int interval;
+		//! the length of the feature vector in each bin
+		int flen;
+		//! the number of orientations per HOG feature bin
+		int norient;
+		//! the threshold for a positive detection
+		float thresh;
+		//! the seed of the random weights and topology
+		int seed;
+	};
+
+	/*! @brief the shape of a face model: 13 viewpoint components of 68 parts */
+	static Parameters face(void);
+	/*! @brief the shape of a person model: 1 component of 26 parts with 6 mixtures */
+	static Parameters person(void);
+	/*! @brief parse the name of a tree topology
+	 *
+	 * @param name one of star, chain, binary or random
+	 * @param tree the parsed topology
+	 * @return true if the name was recognized
+	 */
+	static bool parseTree(const std::string& name, Tree& tree);
+
+	SyntheticModel() {}
+	explicit SyntheticModel(const Parameters& params) { generate(params); }
+	virtual ~SyntheticModel() {}
+	void generate(const Parameters& params);
+};
+
+/*! @brief read a model, or generate one
+ *
+ * @param source an .xml, .yaml (or .mat, with matlab support) model file, or
+ * synthetic:face or synthetic:person for a SyntheticModel of that shape
+ * @return the model, owned by the caller, or NULL (after printing the reason)
+ * if the format is unsupported or the file could not be deserialized
+ */
+Model* loadModel(const std::string& source);
+
+#endif /* SYNTHETICMODEL_HPP_ */
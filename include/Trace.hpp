@@ -0,0 +1,114 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    Trace.hpp
+ *  Created: Oct 19, 2026
+ */
+
+#ifndef TRACE_HPP_
+#define TRACE_HPP_
+#include <ostream>
+#include <string>
+#include <opencv2/core/core.hpp>
+#ifdef WITH_TRACE
+#include <boost/atomic.hpp>
+#endif
+
+/*! @class Trace
+ *  @brief spans of the detection pipeline, for viewing the parallel schedule
+ *
+ *  TRACE_SPAN(name, level, index) records the time between its construction
+ *  and the end of its scope, along with the thread that ran it. Each thread
+ *  writes into its own ring buffer, so recording takes no locks. Once a buffer
+ *  is full, the oldest spans are overwritten
+ *
+ *  write() dumps the buffers as Chrome trace event JSON, which can be opened
+ *  in chrome://tracing or https://ui.perfetto.dev. clear() and write() must not
+ *  be called while a detection is running
+ *
+ *  Tracing is compiled in with the WITH_TRACE CMake option. Without it, the
+ *  spans expand to nothing and the methods below do nothing. With it, spans are
+ *  only recorded once tracing has been enabled
+ */
+class Trace {
+public:
+#ifdef WITH_TRACE
+	//! a completed span
+	struct Event {
+		const char* name;
+		int64 begin, end;
+		int level, index;
+	};
+
+	//! records a span from its construction to its destruction
+	class Span {
+	private:
+		const char* name_;
+		int level_, index_;
+		int64 begin_;
+	public:
+		/*! @param name a string literal naming the span
+		 * @param level the pyramid level the span worked on, or -1
+		 * @param index the filter, component or part the span worked on, or -1
+		 */
+		explicit Span(const char* name, int level = -1, int index = -1) :
+			name_(name), level_(level), index_(index), begin_(enabled() ? cv::getTickCount() : 0) {}
+		~Span() { if (begin_) record(name_, begin_, cv::getTickCount(), level_, index_); }
+	};
+
+	static void enable(bool enable, size_t capacity = 65536);
+	static bool enabled(void) { return enabled_.load(boost::memory_order_relaxed); }
+	static void clear(void);
+	static void write(std::ostream& out);
+	static bool write(const std::string& filename);
+private:
+	static boost::atomic<bool> enabled_;
+	static void record(const char* name, int64 begin, int64 end, int level, int index);
+#else
+	static void enable(bool, size_t = 0) {}
+	static bool enabled(void) { return false; }
+	static void clear(void) {}
+	static void write(std::ostream&) {}
+	static bool write(const std::string&) { return false; }
+#endif
+};
+
+#ifdef WITH_TRACE
+#define TRACE_CONCAT_(a, b) a ## b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SPAN(...) Trace::Span TRACE_CONCAT(trace_span_, __LINE__)(__VA_ARGS__)
+#else
+#define TRACE_SPAN(...)
+#endif
+
+#endif /* TRACE_HPP_ */
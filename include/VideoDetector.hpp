@@ -0,0 +1,131 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    VideoDetector.hpp
+ *  Created: Oct 19, 2026
+ */
+
+#ifndef VIDEODETECTOR_HPP_
+#define VIDEODETECTOR_HPP_
+#include <deque>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include <boost/atomic.hpp>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include "Candidate.hpp"
+#include "Detections.hpp"
+#include "DetectionWorkspace.hpp"
+#include "PartsBasedDetector.hpp"
+
+/*! @class VideoDetector
+ *  @brief a pipelined front end to PartsBasedDetector for streams of frames
+ *
+ *  detect() runs its stages one after the other, so the serial portions of each
+ *  stage leave the other cores idle. VideoDetector runs the stages (feature pyramid,
+ *  convolution, dynamic program, and suppression and backtracking) on their own
+ *  threads, connected by bounded lock-free queues, so that up to depth frames are
+ *  in flight at once. For example, the features of frame t+1 are computed while the
+ *  dynamic program of frame t is running. Each frame in flight has its own
+ *  DetectionWorkspace, so its buffers are reused from one frame to the next
+ *
+ *  Frames are returned in the order they were pushed. If every frame is in flight
+ *  when a new one is pushed, the oldest frame which has not yet been started is
+ *  dropped in its favour. If every frame has been started, the new frame is dropped
+ *
+ *  The stages parallelize internally with OpenMP as in detect(), so they compete
+ *  for the same cores. The gain comes from filling the serial gaps of one stage
+ *  with another, so OMP_NUM_THREADS may be lowered to reduce oversubscription
+ *
+ *  push() and pop() may each be called from one thread (the same one or not)
+ *
+ *  The detector must outlive the VideoDetector, and must not be modified while it runs
+ */
+template<typename T>
+class VideoDetector {
+private:
+	//! a frame in flight, with the buffers of every stage
+	struct Frame {
+		Frame() : workspace(true), submitted(0) {}
+		cv::Mat image;
+		DetectionWorkspace workspace;
+		Detections detections;
+		//! the tick count at which the frame was pushed
+		int64 submitted;
+	};
+	typedef boost::lockfree::spsc_queue<Frame*> FrameQueue;
+	//! the detector to run
+	const PartsBasedDetector<T>& detector_;
+	//! storage for the frames in flight
+	std::vector<Frame> frames_;
+	//! frames which are not in flight
+	std::vector<Frame*> free_;
+	//! frames which have been pushed but not yet started, oldest first
+	std::deque<Frame*> input_;
+	//! guards free_, input_ and the statistics
+	mutable boost::mutex mutex_;
+	//! the queues between the stages, and the finished frames
+	boost::scoped_ptr<FrameQueue> features_, responses_, scores_, done_;
+	boost::thread_group threads_;
+	boost::atomic<bool> running_;
+	//! the number of frames completed and dropped
+	size_t completed_, dropped_;
+	//! the total end-to-end latency of the completed frames, in ticks
+	int64 latency_;
+	//! the tick count of the first push and of the last completion
+	int64 first_, last_;
+	Frame* take(FrameQueue& queue);
+	Frame* takeInput(void);
+	void pyramidStage(void);
+	void convolutionStage(void);
+	void programStage(void);
+	void backtrackStage(void);
+	Frame* finished(void);
+public:
+	VideoDetector(const PartsBasedDetector<T>& detector, size_t depth = 3);
+	virtual ~VideoDetector();
+	bool push(const cv::Mat& frame);
+	bool pop(Detections& detections);
+	bool pop(Detections& detections, cv::Mat& frame);
+	bool pop(vectorCandidate& candidates);
+	//! the maximum number of frames in flight
+	size_t depth(void) const { return frames_.size(); }
+	size_t completed(void) const;
+	size_t dropped(void) const;
+	double throughput(void) const;
+	double latency(void) const;
+};
+
+#endif /* VIDEODETECTOR_HPP_ */
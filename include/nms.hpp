@@ -38,8 +38,12 @@
 
 #ifndef NMS_HPP_
 #define NMS_HPP_
+#include <vector>
 #include <opencv2/core/core.hpp>
+#include "types.hpp"
 void nonMaximaSuppression(const cv::Mat& src, const int sz, cv::Mat& dst, const cv::Mat mask=cv::Mat());
+void nonMaximaSuppression(const cv::Mat& src, const int sz, cv::Mat& dst, const cv::Mat& mask, cv::Mat& neighbours);
+void boxNonMaximaSuppression(const std::vector<cv::Rect>& boxes, const float overlap, vectori& keep, const size_t maxdetections=0);
 
 
 #endif /* NMS_HPP_ */
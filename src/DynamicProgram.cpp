@@ -38,9 +38,51 @@
 
 #include "Math.hpp"
 #include "DynamicProgram.hpp"
+#include "Trace.hpp"
 using namespace cv;
 using namespace std;
 
+/*! @brief the largest gain of a 1D quadratic deformation
+ *
+ * The distance transform returns src[v] + a*d^2 + b*d for some displacement
+ * d = os+q-v, where q and v both index into a row of length N. This returns
+ * the largest value a*d^2 + b*d can take over that range of displacements
+ *
+ * @param a the quadratic coefficient
+ * @param b the linear coefficient
+ * @param os the anchor offset
+ * @param N the length of the row
+ * @return the upper bound on the deformation term
+ */
+static double deformationBound(const double a, const double b, const int os, const int N) {
+	const int dmin = os - (N-1);
+	const int dmax = os + (N-1);
+	double best = std::max(a*dmin*dmin + b*dmin, a*dmax*dmax + b*dmax);
+	if (a < 0) {
+		// the vertex of a concave parabola
+		const double d = -b / (2*a);
+		const int dv[2] = { (int)floor(d), (int)ceil(d) };
+		for (size_t i = 0; i < 2; ++i) {
+			if (dv[i] > dmin && dv[i] < dmax) best = std::max(best, a*dv[i]*dv[i] + b*dv[i]);
+		}
+	}
+	return best;
+}
+
+/*! @brief the floating point type used for the geometry of a score type */
+template<typename T> struct Real { typedef T type; };
+template<> struct Real<int> { typedef double type; };
+
+/*! @brief the deepest part to evaluate at a scale
+ *
+ * @param maxdepth the maximum depth at each scale. Missing or negative entries evaluate the full tree
+ * @param n the scale
+ * @return the maximum depth
+ */
+static int depthLimit(const vectori& maxdepth, size_t n) {
+	return (n < maxdepth.size() && maxdepth[n] >= 0) ? maxdepth[n] : numeric_limits<int>::max();
+}
+
 
 /*! @brief Get the min of a dynamic program
  *
@@ -54,22 +96,70 @@ using namespace std;
  * 		(2) Shift by the anchor position of the part wrt the parent
  * 		(3) Downsample if necessary
  *
- * @param parts the parts tree, referenced by the root
+ * Each scale and component is an independent task graph. Within a graph,
+ * sibling subtrees and the distance transforms of each mixture of a part
+ * are spawned as tasks, and a part is only updated once all of its children
+ * have finished. This exposes parallelism even for single component models
+ * where the number of scales is smaller than the number of threads
+ *
+ * If a maximum depth is given for a scale, only the parts up to that depth
+ * in the tree are evaluated, and the scores of the deeper parts are ignored.
+ * argmin() must then be called with the same maxdepth
+ *
+ * Scales without scores are skipped. Once the deadline expires, the components
+ * which have not yet started are skipped too. The root scores of skipped
+ * components are left empty, so argmin() ignores them
+ *
+ * @param plan the compiled parts tree, referenced by the root
  * @param scores the probability densities (pdfs) of part locations (fine to coarse)
  * @param Ix the detection indices in the x direction
  * @param Iy the detection indices in the y direction
  * @param Ik the best mixture at each pixel
  * @param rootv the root scores, across scale
  * @param rooti the root indices, across scale
+ * @param maxdepth the maximum depth of the parts to evaluate at each scale (optional)
+ * @param deadline the deadline after which no more components are started (optional)
+ * @param stats accounts the working buffers and backtracking maps of each scale and
+ * component to the DP stage, and counts the root locations pruned (optional)
+ * @return false if any component was skipped because the deadline expired
  *
  */
 template<typename T>
-void DynamicProgram<T>::min(Parts& parts, vector2DMat& scores, vector4DMat& Ix, vector4DMat& Iy, vector4DMat& Ik, vector2DMat& rootv, vector2DMat& rooti) {
+bool DynamicProgram<T>::min(const PartsPlan& plan, vector2DMat& scores, vector4DMat& Ix, vector4DMat& Iy, vector4DMat& Ik, vector2DMat& rootv, vector2DMat& rooti, const vectori& maxdepth, const Deadline& deadline, DetectionStats* stats) const {
+	return minScales(plan, scores, Ix, Iy, Ik, rootv, rooti, NULL, maxdepth, deadline, stats);
+}
+
+/*! @brief Get the min of a dynamic program, reusing its working buffers
+ *
+ * As min(), but the intermediate scores, messages and distance transforms are
+ * kept in the buffers between calls. The outputs are also reused, so repeated
+ * calls at the same image size do not allocate any matrices
+ *
+ * @see min()
+ * @param buffers the working buffers of each scale and component, kept between calls
+ */
+template<typename T>
+bool DynamicProgram<T>::min(const PartsPlan& plan, vector2DMat& scores, vector4DMat& Ix, vector4DMat& Iy, vector4DMat& Ik, vector2DMat& rootv, vector2DMat& rooti, vector2DComponentBuffers& buffers, const vectori& maxdepth, const Deadline& deadline, DetectionStats* stats) const {
+	buffers.resize(scores.size());
+	for (size_t n = 0; n < buffers.size(); ++n) buffers[n].resize(plan.ncomponents());
+	return minScales(plan, scores, Ix, Iy, Ik, rootv, rooti, &buffers, maxdepth, deadline, stats);
+}
+
+/*! @brief Get the min of a dynamic program across scales and components
+ *
+ * @param buffers the working buffers of each scale and component, or NULL to
+ * release the working buffers of each component as soon as it is finished
+ * @param stats accounts the buffers of each scale and component, or NULL. Working
+ * buffers which are released are accounted at their peak and then released
+ * @see min()
+ */
+template<typename T>
+bool DynamicProgram<T>::minScales(const PartsPlan& plan, vector2DMat& scores, vector4DMat& Ix, vector4DMat& Iy, vector4DMat& Ik, vector2DMat& rootv, vector2DMat& rooti, vector2DComponentBuffers* buffers, const vectori& maxdepth, const Deadline& deadline, DetectionStats* stats) const {
 
 	// initialize the outputs, preallocate vectors to make them thread safe
 	// TODO: better initialisation of Ix, Iy, Ik
 	const size_t nscales = scores.size();
-	const size_t ncomponents = parts.ncomponents();
+	const size_t ncomponents = plan.ncomponents();
 	Ix.resize(nscales, vector3DMat(ncomponents));
 	Iy.resize(nscales, vector3DMat(ncomponents));
 	Ik.resize(nscales, vector3DMat(ncomponents));
@@ -77,98 +167,344 @@ void DynamicProgram<T>::min(Parts& parts, vector2DMat& scores, vector4DMat& Ix,
 	rooti.resize(nscales, vectorMat(ncomponents));
 
 	// for each scale, and each component, update the scores through message passing
+	bool complete = true;
 	#ifdef _OPENMP
-	#pragma omp parallel for
+	#pragma omp parallel
+	#pragma omp single
 	#endif
 	for (size_t nc = 0; nc < nscales*ncomponents; ++nc) {
-
 		// calculate the inner loop variables from the dual variables
-		const size_t n = floor(nc / ncomponents);
-		const size_t c = nc % ncomponents;
-
-		// allocate the inner loop variables
-		Ix[n][c].resize(parts.nparts(c));
-		Iy[n][c].resize(parts.nparts(c));
-		Ik[n][c].resize(parts.nparts(c));
-		vectorMat ncscores(scores[n].size());
-
-		for (int p = parts.nparts(c)-1; p > 0; --p) {
-
-			// get the component part (which may have multiple mixtures associated with it)
-			ComponentPart cpart = parts.component(c, p);
-			const size_t nmixtures  = cpart.nmixtures();
-			const size_t pnmixtures = cpart.parent().nmixtures();
-			Ix[n][c][p].resize(pnmixtures);
-			Iy[n][c][p].resize(pnmixtures);
-			Ik[n][c][p].resize(pnmixtures);
-
-			// intermediate results for mixtures of this part
-			vectorMat scoresp;
-			vectorMat Ixp;
-			vectorMat Iyp;
-
-			for (size_t m = 0; m < nmixtures; ++m) {
-
-				// raw score outputs
-				Mat_<T> score_in, score_dt;
-				Mat_<int> Ix_dt, Iy_dt;
-				if (cpart.score(ncscores, m).empty()) {
-					score_in = cpart.score(scores[n], m);
-				} else {
-					score_in = cpart.score(ncscores, m);
+		size_t n = nc / ncomponents;
+		size_t c = nc % ncomponents;
+		// the outputs may hold the results of a previous call
+		rootv[n][c] = Mat();
+		rooti[n][c] = Mat();
+		if (scores[n].empty() || scores[n][0].empty()) continue;
+		#ifdef _OPENMP
+		#pragma omp task default(shared) firstprivate(n, c)
+		#endif
+		{
+			if (deadline.expired()) {
+				#ifdef _OPENMP
+				#pragma omp critical(deadline)
+				#endif
+				complete = false;
+			} else {
+				TRACE_SPAN("component", n, c);
+				ComponentBuffers transient;
+				ComponentBuffers& buffersnc = buffers ? (*buffers)[n][c] : transient;
+				minComponent(plan.component(c), depthLimit(maxdepth, n), scores[n], Ix[n][c], Iy[n][c], Ik[n][c], rootv[n][c], rooti[n][c], buffersnc, stats);
+				if (stats) {
+					// the root scores are headers onto the working buffers, which outlive
+					// them if they are kept, and are outlived by them if not
+					typedef DetectionStats::Memory M;
+					const size_t maps = M::size(Ix[n][c]) + M::size(Iy[n][c]) + M::size(Ik[n][c]) + (buffers ?
+							M::size(buffersnc.rootv) + M::size(buffersnc.rooti) : M::size(rootv[n][c]) + M::size(rooti[n][c]));
+					const size_t working = M::size(buffersnc.scores) + M::size(buffersnc.messages) + M::size(buffersnc.dt) + M::size(buffersnc.Ixdt) + M::size(buffersnc.Iydt) +
+							M::size(buffersnc.mask) + M::size(buffersnc.reachable);
+					stats->memory.allocate(DetectionStats::DP, n, c, maps + working);
+					if (!buffers) stats->memory.release(DetectionStats::DP, n, c, working);
 				}
-
-				// get the anchor position
-				Point anchor = cpart.anchor(m);
-
-				// compute the distance transform
-				vectorf w = cpart.defw(m);
-				Quadratic fx(-w[0], -w[1]);
-				Quadratic fy(-w[2], -w[3]);
-				dt_.compute(score_in, fx, fy, anchor, score_dt, Ix_dt, Iy_dt);
-				scoresp.push_back(score_dt);
-				Ixp.push_back(Ix_dt);
-				Iyp.push_back(Iy_dt);
 			}
+		}
+	}
+	return complete;
+}
 
-			for (size_t m = 0; m < pnmixtures; ++m) {
-				vectorMat weighted;
-				// weight each of the child scores
-				// TODO: More elegant way of handling bias
-				for (size_t mm = 0; mm < nmixtures; ++mm) {
-					weighted.push_back(scoresp[mm] + cpart.bias(mm)[m]);
-				}
-				// compute the max over the mixtures
-				Mat maxv, maxi;
-				Math::reduceMax<T>(weighted, maxv, maxi);
-
-				// choose the best indices
-				Mat Ixm, Iym;
-				Math::reducePickIndex<int>(Ixp, maxi, Ixm);
-				Math::reducePickIndex<int>(Iyp, maxi, Iym);
-				Ix[n][c][p][m] = Ixm;
-				Iy[n][c][p][m] = Iym;
-				Ik[n][c][p][m] = maxi;
-
-				// update the parent's score
-				ComponentPart parent = cpart.parent();
-				if (parent.score(ncscores,m).empty()) parent.score(scores[n],m).copyTo(parent.score(ncscores,m));
-				parent.score(ncscores,m) += maxv;
-				if (parent.self() == 0) {
-					ComponentPart root = parts.component(c);
-				}
-			}
+/*! @brief Get the min of a dynamic program for a single scale and component
+ *
+ * @param plan the compiled component
+ * @param maxdepth the maximum depth of the parts to evaluate
+ * @param scores the pdfs of part locations at the current scale
+ * @param Ix the detection indices in the x direction
+ * @param Iy the detection indices in the y direction
+ * @param Ik the best mixture at each pixel
+ * @param rootv the root scores, left empty if the component is pruned. Pruned root
+ * locations are set to the lowest score
+ * @param rooti the root indices
+ * @param buffers the working buffers of the component
+ * @param stats counts the root locations evaluated and pruned (optional)
+ */
+template<typename T>
+void DynamicProgram<T>::minComponent(const ComponentPlan& plan, int maxdepth, vectorMat& scores, vector2DMat& Ix, vector2DMat& Iy, vector2DMat& Ik, Mat& rootv, Mat& rooti, ComponentBuffers& buffers, DetectionStats* stats) const {
+
+	// allocate the inner loop variables. The children of each part are stored
+	// in descending order in the plan, so messages are accumulated in the parent
+	// in the same order as the serial leaf-to-root traversal
+	const size_t nparts = plan.nparts();
+	Ix.resize(nparts);
+	Iy.resize(nparts);
+	Ik.resize(nparts);
+	for (size_t p = 1; p < nparts; ++p) {
+		const size_t pnmixtures = plan.nmixtures(plan.parent(p));
+		Ix[p].resize(pnmixtures);
+		Iy[p].resize(pnmixtures);
+		Ik[p].resize(pnmixtures);
+	}
+	buffers.scores.resize(nparts);
+	buffers.partscores.resize(nparts);
+	buffers.messages.resize(nparts);
+	buffers.dt.resize(nparts);
+	buffers.Ixdt.resize(nparts);
+	buffers.Iydt.resize(nparts);
+
+	// find the root locations which could reach the threshold: those where the
+	// response of a root mixture, plus the best messages its children could
+	// possibly pass, plus the bias, is above it. The mixtures without any such
+	// location are not computed. If there are none at all, the component is
+	// skipped and the root scores are left empty
+	const float bias = plan.rootBias();
+	const size_t nmixtures = plan.nmixtures(0);
+	const size_t nroots = scores[plan.filter(0, 0)].total();
+	std::vector<bool> viable(nmixtures, true);
+	Mat mask;
+	// the masks are created whether or not pruning is enabled, so that a workspace
+	// prepared without pruning holds every buffer of a pruned search
+	buffers.mask.create(scores[plan.filter(0, 0)].size(), CV_8U);
+	buffers.reachable.create(buffers.mask.size(), CV_8U);
+	if (prune_) {
+		buffers.mask.setTo(0);
+		std::vector<double> bound;
+		double magnitude = 0;
+		messageBound(plan, 0, maxdepth, scores, bound, magnitude);
+		bool any = false;
+		for (size_t m = 0; m < nmixtures; ++m) {
+			const Mat& appearance = scores[plan.filter(0, m)];
+			double best;
+			minMaxLoc(appearance, NULL, &best);
+			// allow for the rounding of the scores, which are accumulated in T
+			const double slack = 1e-4 * (1.0 + magnitude + fabs(best) + fabs(bias));
+			compare(appearance, thresh_*scale_ - slack - bias - bound[m], buffers.reachable, CMP_GT);
+			viable[m] = countNonZero(buffers.reachable) > 0;
+			any = any || viable[m];
+			if (viable[m]) bitwise_or(buffers.mask, buffers.reachable, buffers.mask);
+		}
+		mask = buffers.mask;
+		if (!any) {
+			if (stats) stats->countRoots(nroots, nroots);
+			return;
+		}
+		if (stats) stats->countRoots(nroots, nroots - countNonZero(mask));
+	} else if (stats) {
+		stats->countRoots(nroots, 0);
+	}
+
+	// each part owns its accumulated scores and its message to the parent,
+	// so no locking is required when the subtrees are updated concurrently
+	minSubtree(plan, 0, maxdepth, viable, scores, buffers, Ix, Iy, Ik);
+
+	// add bias to the root score and find the best mixture at the reachable locations
+	Math::reduceMax<T>(buffers.partscores[0], &bias, 0, buffers.rootv, buffers.rooti, mask);
+	rootv = buffers.rootv;
+	rooti = buffers.rooti;
+}
+
+/*! @brief accumulate the scores of a subtree into its root part
+ *
+ * The messages of each child subtree are computed concurrently, then
+ * added to the appearance score of the part
+ *
+ * @param plan the compiled component
+ * @param p the part at the root of the subtree
+ * @param maxdepth the maximum depth of the parts to evaluate
+ * @param viable the mixtures of the part that need to be computed. The others
+ * are set to the lowest score
+ * @param scores the pdfs of part locations at the current scale
+ * @param buffers the accumulated scores and messages of each part's mixtures
+ * @param Ix the detection indices in the x direction
+ * @param Iy the detection indices in the y direction
+ * @param Ik the best mixture at each pixel
+ */
+template<typename T>
+void DynamicProgram<T>::minSubtree(const ComponentPlan& plan, int p, int maxdepth, const std::vector<bool>& viable,
+		vectorMat& scores, ComponentBuffers& buffers, vector2DMat& Ix, vector2DMat& Iy, vector2DMat& Ik) const {
+
+	// sibling subtrees are independent. Below the maximum depth, the part is treated as a leaf
+	const size_t nchildren = plan.depth(p) < maxdepth ? plan.nchildren(p) : 0;
+	for (size_t i = 0; i < nchildren; ++i) {
+		const int q = plan.child(p, i);
+		#ifdef _OPENMP
+		#pragma omp task default(shared) firstprivate(q)
+		#endif
+		{
+			const std::vector<bool> all(plan.nmixtures(q), true);
+			minSubtree(plan, q, maxdepth, all, scores, buffers, Ix, Iy, Ik);
+			message(plan, q, viable, buffers, Ix[q], Iy[q], Ik[q]);
+		}
+	}
+	#ifdef _OPENMP
+	#pragma omp taskwait
+	#endif
+
+	// update the part's score with the messages from its children. Leaves refer
+	// to their appearance directly, which is never written through
+	const size_t nmixtures = plan.nmixtures(p);
+	vectorMat& accumulated = buffers.scores[p];
+	vectorMat& partscores = buffers.partscores[p];
+	accumulated.resize(nmixtures);
+	partscores.resize(nmixtures);
+	for (size_t m = 0; m < nmixtures; ++m) {
+		const Mat& appearance = scores[plan.filter(p, m)];
+		if (!viable[m]) {
+			accumulated[m].create(appearance.size(), appearance.type());
+			accumulated[m].setTo(Scalar::all(Math::lowest<T>()));
+			partscores[m] = accumulated[m];
+			continue;
+		}
+		if (nchildren == 0) {
+			partscores[m] = appearance;
+			continue;
+		}
+		appearance.copyTo(accumulated[m]);
+		for (size_t i = 0; i < nchildren; ++i) {
+			accumulated[m] += buffers.messages[plan.child(p, i)][m];
+		}
+		partscores[m] = accumulated[m];
+	}
+}
+
+/*! @brief compute the message passed from a part to each of its parent's mixtures
+ *
+ * @param plan the compiled component
+ * @param p the part sending the message
+ * @param viable the mixtures of the parent that need a message
+ * @param buffers the accumulated scores, messages and distance transforms of each part's mixtures
+ * @param Ix the detection indices in the x direction for the part
+ * @param Iy the detection indices in the y direction for the part
+ * @param Ik the best mixture at each pixel for the part
+ */
+template<typename T>
+void DynamicProgram<T>::message(const ComponentPlan& plan, int p, const std::vector<bool>& viable, ComponentBuffers& buffers,
+		vectorMat& Ix, vectorMat& Iy, vectorMat& Ik) const {
+
+	// get the component part (which may have multiple mixtures associated with it)
+	const size_t nmixtures  = plan.nmixtures(p);
+	const size_t pnmixtures = plan.nmixtures(plan.parent(p));
+
+	// intermediate results for mixtures of this part
+	vectorMat& scoresp = buffers.dt[p];
+	vectorMat& Ixp = buffers.Ixdt[p];
+	vectorMat& Iyp = buffers.Iydt[p];
+	scoresp.resize(nmixtures);
+	Ixp.resize(nmixtures);
+	Iyp.resize(nmixtures);
+
+	// the distance transform of each mixture is independent
+	for (size_t m = 0; m < nmixtures; ++m) {
+		#ifdef _OPENMP
+		#pragma omp task default(shared) firstprivate(m)
+		#endif
+		{
+			// raw score outputs, reusing the storage of the previous call
+			Mat_<T> score_in = buffers.partscores[p][m];
+			Mat_<T> score_dt = scoresp[m];
+			Mat_<int> Ix_dt = Ixp[m], Iy_dt = Iyp[m];
+
+			// compute the distance transform
+			const float* w = plan.defw(p, m);
+			Quadratic fx(-w[0], -w[1]);
+			Quadratic fy(-w[2], -w[3]);
+			dt_.compute(score_in, fx, fy, plan.anchor(p, m), score_dt, Ix_dt, Iy_dt);
+			scoresp[m] = score_dt;
+			Ixp[m] = Ix_dt;
+			Iyp[m] = Iy_dt;
+		}
+	}
+	#ifdef _OPENMP
+	#pragma omp taskwait
+	#endif
+
+	// the reduction over mixtures is independent for each parent mixture
+	vectorMat& messages = buffers.messages[p];
+	messages.resize(pnmixtures);
+	for (size_t m = 0; m < pnmixtures; ++m) {
+		if (!viable[m]) continue;
+		#ifdef _OPENMP
+		#pragma omp task default(shared) firstprivate(m)
+		#endif
+		{
+			// compute the max over the biased mixtures
+			Math::reduceMax<T>(scoresp, plan.bias(p, m), plan.biasstride(p), messages[m], Ik[m]);
+
+			// choose the best indices
+			Math::reducePickIndex<int>(Ixp, Ik[m], Ix[m]);
+			Math::reducePickIndex<int>(Iyp, Ik[m], Iy[m]);
+		}
+	}
+	#ifdef _OPENMP
+	#pragma omp taskwait
+	#endif
+}
+
+
+/*! @brief compute an upper bound on the score of each mixture of a part
+ *
+ * The bound assumes that the part and all of its descendants attain the
+ * maximum of their filter responses, with the most favourable deformation
+ * and bias. It is computed from the response maxima alone, so it is cheap
+ * compared to the distance transforms it allows us to skip
+ *
+ * @param plan the compiled component
+ * @param p the part at the root of the subtree
+ * @param maxdepth the maximum depth of the parts to include in the bound
+ * @param scores the pdfs of part locations at the current scale
+ * @param bound the output bound for each mixture of the part
+ * @param magnitude accumulates the magnitude of the terms in the bound
+ */
+template<typename T>
+void DynamicProgram<T>::upperBound(const ComponentPlan& plan, int p, int maxdepth, vectorMat& scores, std::vector<double>& bound, double& magnitude) const {
+
+	messageBound(plan, p, maxdepth, scores, bound, magnitude);
+	for (size_t m = 0; m < bound.size(); ++m) {
+		double best;
+		minMaxLoc(scores[plan.filter(p, m)], NULL, &best);
+		bound[m] += best;
+		magnitude += fabs(best);
+	}
+}
+
+/*! @brief compute an upper bound on the sum of the messages passed to each mixture of a part
+ *
+ * As upperBound(), for the children of the part alone. Adding the response of
+ * the part at a location bounds the score of the subtree at that location
+ *
+ * @param plan the compiled component
+ * @param p the part receiving the messages
+ * @param maxdepth the maximum depth of the parts to include in the bound
+ * @param scores the pdfs of part locations at the current scale
+ * @param bound the output bound for each mixture of the part
+ * @param magnitude accumulates the magnitude of the terms in the bound
+ */
+template<typename T>
+void DynamicProgram<T>::messageBound(const ComponentPlan& plan, int p, int maxdepth, vectorMat& scores, std::vector<double>& bound, double& magnitude) const {
+
+	const size_t nmixtures = plan.nmixtures(p);
+	bound.assign(nmixtures, 0);
+
+	// add the best message each child could possibly pass
+	const size_t nchildren = plan.depth(p) < maxdepth ? plan.nchildren(p) : 0;
+	for (size_t i = 0; i < nchildren; ++i) {
+		const int q = plan.child(p, i);
+		const size_t cnmixtures = plan.nmixtures(q);
+		const size_t stride = plan.biasstride(q);
+		std::vector<double> cbound;
+		upperBound(plan, q, maxdepth, scores, cbound, magnitude);
+		for (size_t mm = 0; mm < cnmixtures; ++mm) {
+			const Size size = scores[plan.filter(q, mm)].size();
+			const Point& anchor = plan.anchor(q, mm);
+			const float* w = plan.defw(q, mm);
+			cbound[mm] += deformationBound(-w[0], -w[1], anchor.x, size.width) +
+						  deformationBound(-w[2], -w[3], anchor.y, size.height);
 		}
-		// add bias to the root score and find the best mixture
-		ComponentPart root = parts.component(c);
-		Mat rncscore = root.score(ncscores,0);
-		T bias = root.bias(0)[0];
-		vectorMat weighted;
-		// weight each of the child scores
-		for (size_t m = 0; m < root.nmixtures(); ++m) {
-			weighted.push_back(root.score(ncscores,m) + bias);
+		for (size_t m = 0; m < nmixtures; ++m) {
+			const float* bias = plan.bias(q, m);
+			double best = -numeric_limits<double>::infinity();
+			for (size_t mm = 0; mm < cnmixtures; ++mm) {
+				best = std::max(best, cbound[mm] + bias[mm*stride]);
+			}
+			bound[m] += best;
+			magnitude += fabs(best);
 		}
-		Math::reduceMax<T>(weighted, rootv[n][c], rooti[n][c]);
 	}
 }
 
@@ -176,87 +512,129 @@ void DynamicProgram<T>::min(Parts& parts, vector2DMat& scores, vector4DMat& Ix,
 /*! @brief get the argmin of a dynamic program
  *
  * Get the minimum argument of a dynamic program by traversing down the tree of
- * a dynamic program, returning the locations of the best nodes
- * @param parts the tree of parts, referenced by the root
+ * a dynamic program, returning the locations of the best nodes. Parts beyond the
+ * maximum depth at a scale are placed at their anchor relative to their parent,
+ * using the mixture with the largest bias
+ *
+ * Each scale is backtracked into its own Detections buffer, without locking or
+ * per-candidate allocation. The buffers are merged in scale order once all scales
+ * have finished, so the output order does not depend on the number of threads
+ *
+ * @param plan the compiled tree of parts, referenced by the root
  * @param rootv the root scores, across scale
  * @param rooti the root indices, across scale
  * @param scales the scales (used to calculate bounding box size)
  * @param Ix the detection indices in the x direction
  * @param Iy the detection indices in the y direction
  * @param Ik the best mixture at each pixel
- * @param candidates
+ * @param detections the output detections, appended to
+ * @param maxdepth the maximum depth of the parts evaluated by min() at each scale (optional)
  */
 template<typename T>
-void DynamicProgram<T>::argmin(Parts& parts, const vector2DMat& rootv, const vector2DMat& rooti, const vectorf scales, const vector4DMat& Ix, const vector4DMat& Iy, const vector4DMat& Ik, vectorCandidate& candidates) {
+void DynamicProgram<T>::argmin(const PartsPlan& plan, const vector2DMat& rootv, const vector2DMat& rooti, const vectorf scales, const vector4DMat& Ix, const vector4DMat& Iy, const vector4DMat& Ik, Detections& detections, const vectori& maxdepth) const {
 
 	// for each scale, and each component, traverse back down the tree to retrieve the part positions
 	const size_t nscales = scales.size();
+	std::vector<Detections> buffers(nscales);
 	#ifdef _OPENMP
 	#pragma omp parallel for
 	#endif
 	for (size_t n = 0; n < nscales; ++n) {
-		T scale = scales[n];
-		for (size_t c = 0; c < parts.ncomponents(); ++c) {
+		TRACE_SPAN("argmin", n);
+		const typename Real<T>::type scale = scales[n];
+		const typename Real<T>::type thresh = thresh_*scale_;
+		const int depth = depthLimit(maxdepth, n);
+		vectorPoint inds;
+		for (size_t c = 0; c < plan.ncomponents(); ++c) {
 
 			// get the scores and indices for this tree of parts
 			const vector2DMat& Iknc = Ik[n][c];
 			const vector2DMat& Ixnc = Ix[n][c];
 			const vector2DMat& Iync = Iy[n][c];
-			const size_t nparts = parts.nparts(c);
+			const ComponentPlan& cplan = plan.component(c);
+			const size_t nparts = cplan.nparts();
 
-			// threshold the root score
-			Mat over_thresh = rootv[n][c] > thresh_;
-			Mat rootmix     = rooti[n][c];
-			vectorPoint inds;
-			Math::find(over_thresh, inds);
+			// the component was pruned at this scale
+			if (rootv[n][c].empty()) continue;
 
+			// threshold the root score, in row-major order
+			const Mat& root = rootv[n][c];
+			const Mat& rootmix = rooti[n][c];
+			inds.clear();
+			for (int y = 0; y < root.rows; ++y) {
+				const T* root_ptr = root.ptr<T>(y);
+				for (int x = 0; x < root.cols; ++x) if (root_ptr[x] > thresh) inds.push_back(Point(x,y));
+			}
+			buffers[n].reserve(buffers[n].size() + inds.size(), nparts);
+
+			// the part positions are reused for each root location
+			vectori xv(nparts);
+			vectori yv(nparts);
+			vectori mv(nparts);
+			std::vector<Rect> rects(nparts);
 			for (size_t i = 0; i < inds.size(); ++i) {
-				Candidate candidate;
-				candidate.setComponent(c);
-				vectori     xv(nparts);
-				vectori     yv(nparts);
-				vectori     mv(nparts);
 				for (size_t p = 0; p < nparts; ++p) {
-					ComponentPart part = parts.component(c, p);
 					// calculate the child's points from the parent's points
 					size_t x, y, m;
-					if (part.isRoot()) {
+					if (p == 0) {
 						x = xv[0] = inds[i].x;
 						y = yv[0] = inds[i].y;
 						m = mv[0] = rootmix.at<int>(inds[i]);
 					} else {
-						int idx = part.parent().self();
+						int idx = cplan.parent(p);
 						x = xv[idx];
 						y = yv[idx];
 						m = mv[idx];
-						xv[p] = Ixnc[p][m].at<int>(y,x);
-						yv[p] = Iync[p][m].at<int>(y,x);
-						mv[p] = Iknc[p][m].at<int>(y,x);
+						if (cplan.depth(p) <= depth) {
+							xv[p] = Ixnc[p][m].at<int>(y,x);
+							yv[p] = Iync[p][m].at<int>(y,x);
+							mv[p] = Iknc[p][m].at<int>(y,x);
+						} else {
+							// interpolate the part from the anchor of its most likely mixture
+							const float* bias = cplan.bias(p, m);
+							const size_t stride = cplan.biasstride(p);
+							size_t best = 0;
+							for (size_t mm = 1; mm < cplan.nmixtures(p); ++mm) {
+								if (bias[mm*stride] > bias[best*stride]) best = mm;
+							}
+							const Point& anchor = cplan.anchor(p, best);
+							xv[p] = x + anchor.x;
+							yv[p] = y + anchor.y;
+							mv[p] = best;
+						}
 					}
 
-					// calculate the bounding rectangle and add it to the Candidate
+					// calculate the bounding rectangle of the part
 					Point pone = Point(1,1);
 					Point xy1 = (Point(xv[p],yv[p])-pone)*scale;
-					Point xy2 = xy1 + Point(part.xsize(mv[p]), part.ysize(mv[p]))*scale - pone;
-					if (part.isRoot()) 
-					  candidate.addPart(Rect(xy1, xy2), rootv[n][c].at<T>(inds[i]));
-					else
-					  candidate.addPart(Rect(xy1, xy2), 0.0);
-				}
-				#ifdef _OPENMP
-				#pragma omp critical(addcandidate)
-				#endif
-				{
-					candidates.push_back(candidate);
+					const Size& size = cplan.size(p, mv[p]);
+					Point xy2 = xy1 + Point(size.width, size.height)*scale - pone;
+					rects[p] = Rect(xy1, xy2);
 				}
+				buffers[n].push_back(rootv[n][c].at<T>(inds[i]) / scale_, c, n, &rects[0], nparts);
 			}
 		}
 	}
+
+	// merge the detections of each scale
+	for (size_t n = 0; n < nscales; ++n) detections.append(buffers[n]);
+}
+
+/*! @brief get the argmin of a dynamic program as a vector of Candidates
+ *
+ * @see argmin()
+ */
+template<typename T>
+void DynamicProgram<T>::argmin(const PartsPlan& plan, const vector2DMat& rootv, const vector2DMat& rooti, const vectorf scales, const vector4DMat& Ix, const vector4DMat& Iy, const vector4DMat& Ik, vectorCandidate& candidates, const vectori& maxdepth) const {
+	Detections detections;
+	argmin(plan, rootv, rooti, scales, Ix, Iy, Ik, detections, maxdepth);
+	detections.toCandidates(candidates);
 }
 
 
 
 // declare all specializations of the template (this must be the last declaration in the file)
+template class DynamicProgram<int>;
 template class DynamicProgram<float>;
 template class DynamicProgram<double>;
 
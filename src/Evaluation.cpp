@@ -0,0 +1,529 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    Evaluation.cpp
+ *  Created: Oct 19, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <opencv2/core/core.hpp>
+#if CV_MAJOR_VERSION >= 3
+#include <opencv2/imgcodecs.hpp>
+#else
+#include <opencv2/highgui/highgui.hpp>
+#endif
+#include "PartsBasedDetector.hpp"
+#include "Candidate.hpp"
+#include "SyntheticModel.hpp"
+#include "Metrics.hpp"
+#include "types.hpp"
+using namespace cv;
+using namespace std;
+
+/*! @brief one point in the matrix of speed options */
+struct Configuration {
+	string precision;
+	bool fixed;
+	int window;
+	int topk;
+	int height;
+	int depth;
+	bool pruning;
+	int interval;
+	string label(void) const {
+		return format("%s%s interval=%d suppression=%d:%d reduced=%d:%d pruning=%d", precision.c_str(),
+				fixed ? "+fixed" : "", interval, window, topk, height, depth, pruning);
+	}
+};
+
+/*! @brief the accuracy and latency of a configuration */
+struct Result {
+	Configuration configuration;
+	double pck;
+	double apk;
+	double ap;
+	double latency;
+	double p95;
+	size_t detections;
+	bool optimal;
+	double accuracy(const string& metric) const { return metric == "pck" ? pck : metric == "apk" ? apk : ap; }
+};
+
+/*! @brief the options of an evaluation */
+struct Options {
+	Options() : nms(0.3), threshold(0.5), overlap(0.5), thresh(0), setthresh(false), metric("pck"), output(NULL) {}
+	vector<string> precisions;
+	vectori fixed;
+	vector<Point> suppression;
+	vector<Point> reduced;
+	vectori pruning;
+	vectori intervals;
+	vectori keypoints;
+	double nms;
+	double threshold;
+	double overlap;
+	float thresh;
+	bool setthresh;
+	string metric;
+	string detections;
+	FILE* output;
+};
+
+/*! @brief the ascending order of results by latency */
+static bool faster(const Result& a, const Result& b) { return a.latency < b.latency; }
+
+static double mean(const vector<double>& values) {
+	return values.empty() ? 0 : std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+}
+
+/*! @brief the p-th percentile of a sorted vector, by nearest rank */
+static double percentile(const vector<double>& sorted, double p) {
+	if (sorted.empty()) return 0;
+	const size_t rank = (size_t)ceil(p / 100.0 * sorted.size());
+	return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+}
+
+/*! @brief read a list of x,y coordinates */
+static vector<Point2f> readPoints(const FileNode& node) {
+	vectorf xy;
+	node >> xy;
+	vector<Point2f> points;
+	for (size_t n = 0; n+1 < xy.size(); n += 2) points.push_back(Point2f(xy[n], xy[n+1]));
+	return points;
+}
+
+/*! @brief read an x,y,width,height box */
+static Rect readBox(const FileNode& node) {
+	vectori box;
+	node >> box;
+	return box.size() == 4 ? Rect(box[0], box[1], box[2], box[3]) : Rect();
+}
+
+/*! @brief the bounding box of a set of points */
+static Rect pointBox(const vector<Point2f>& points) {
+	if (points.empty()) return Rect();
+	Point2f tl = points[0], br = points[0];
+	for (size_t n = 1; n < points.size(); ++n) {
+		tl.x = std::min(tl.x, points[n].x); tl.y = std::min(tl.y, points[n].y);
+		br.x = std::max(br.x, points[n].x); br.y = std::max(br.y, points[n].y);
+	}
+	return Rect(Point(tl.x, tl.y), Point(br.x, br.y));
+}
+
+/*! @brief read the ground truth of a dataset
+ *
+ * The annotations are a cv::FileStorage file with a sequence of images, each with
+ * a file (relative to the annotations) and a sequence of objects. Each object has
+ * its keypoints as [x0, y0, x1, y1, ...], and optionally a box as [x, y, width,
+ * height] (by default the bounds of the keypoints) and a scale (by default the
+ * larger side of the box)
+ */
+static bool readAnnotations(const string& filename, vector<string>& files, DatasetAnnotations& truth) {
+	FileStorage fs(filename, FileStorage::READ);
+	if (!fs.isOpened()) return false;
+	const boost::filesystem::path root = boost::filesystem::path(filename).parent_path();
+	FileNode images = fs["images"];
+	for (FileNodeIterator it = images.begin(); it != images.end(); ++it) {
+		FileNode image = *it;
+		string file;
+		image["file"] >> file;
+		files.push_back((root / file).string());
+		vector<Annotation> objects;
+		FileNode nodes = image["objects"];
+		for (FileNodeIterator ot = nodes.begin(); ot != nodes.end(); ++ot) {
+			FileNode node = *ot;
+			Annotation object;
+			object.points = readPoints(node["points"]);
+			object.box = node["box"].empty() ? pointBox(object.points) : readBox(node["box"]);
+			object.scale = node["scale"].empty() ? std::max(object.box.width, object.box.height) : (double)node["scale"];
+			objects.push_back(object);
+		}
+		truth.push_back(objects);
+	}
+	return true;
+}
+
+/*! @brief read the detections of a dataset, in the order of the annotations
+ *
+ * The detections have the same layout as the annotations, with a sequence of
+ * detections per image, each with a score, its keypoints and optionally a box
+ */
+static bool readDetections(const string& filename, DatasetDetections& detections) {
+	FileStorage fs(filename, FileStorage::READ);
+	if (!fs.isOpened()) return false;
+	FileNode images = fs["images"];
+	for (FileNodeIterator it = images.begin(); it != images.end(); ++it) {
+		vector<KeypointDetection> image;
+		FileNode nodes = (*it)["detections"];
+		for (FileNodeIterator dt = nodes.begin(); dt != nodes.end(); ++dt) {
+			FileNode node = *dt;
+			KeypointDetection detection;
+			detection.points = readPoints(node["points"]);
+			detection.box = node["box"].empty() ? pointBox(detection.points) : readBox(node["box"]);
+			detection.score = (float)node["score"];
+			image.push_back(detection);
+		}
+		detections.push_back(image);
+	}
+	return true;
+}
+
+/*! @brief check that the selected keypoints are parts of every component of a model
+ *
+ * A keypoint which selected a missing part would shift every later keypoint
+ * onto the wrong ground truth point, so the selection is rejected instead
+ *
+ * @param model the model
+ * @param selection the model part of each ground truth keypoint. Empty selects every part
+ * @return false if any keypoint selects a part which a component does not have
+ */
+static bool validKeypoints(Model& model, const vectori& selection) {
+	if (model.ncomponents() == 0) return selection.empty();
+	size_t nparts = model.filterid()[0].size();
+	for (int c = 1; c < model.ncomponents(); ++c) nparts = std::min(nparts, model.filterid()[c].size());
+	for (size_t k = 0; k < selection.size(); ++k) {
+		if (selection[k] < 0 || selection[k] >= (int)nparts) {
+			printf("Keypoint %ld selects part %d, but the components of the model have %ld parts\n", k, selection[k], nparts);
+			return false;
+		}
+	}
+	return true;
+}
+
+/*! @brief convert candidates into keypoint detections, at the centre of the selected parts
+ *
+ * The selection must have been checked with validKeypoints()
+ */
+static void keypoints(const vectorCandidate& candidates, const vectori& selection, vector<KeypointDetection>& detections) {
+	detections.clear();
+	for (size_t n = 0; n < candidates.size(); ++n) {
+		const vector<Rect>& parts = candidates[n].parts();
+		KeypointDetection detection;
+		detection.score = candidates[n].score();
+		detection.box = candidates[n].boundingBox();
+		const size_t npoints = selection.empty() ? parts.size() : selection.size();
+		for (size_t k = 0; k < npoints; ++k) {
+			const int p = selection.empty() ? k : selection[k];
+			detection.points.push_back(Point2f(parts[p].x + parts[p].width / 2.0f, parts[p].y + parts[p].height / 2.0f));
+		}
+		detections.push_back(detection);
+	}
+}
+
+/*! @brief the accuracy of detections against the ground truth
+ *
+ * APK is evaluated in parallel over the keypoints. PCK and the box AP are a
+ * single pass over the dataset, so they run on their own
+ */
+static void evaluate(const DatasetDetections& detections, const DatasetAnnotations& truth, const Options& options, Result& result) {
+	result.pck = mean(Metrics::pck(detections, truth, options.threshold));
+	result.apk = mean(Metrics::apk(detections, truth, options.threshold));
+	result.ap = Metrics::voc(detections, truth, options.overlap);
+}
+
+/*! @brief restore the filters and pyramid of a model as they were loaded
+ *
+ * distributeModel() converts the filters of the model to the precision of the
+ * detector in place, so without this a double configuration which follows a
+ * float one would run with float-rounded weights. Each configuration also sets
+ * the interval of the pyramid
+ *
+ * @param model the model to restore
+ * @param filters the filters of the model as they were loaded
+ * @param nscales the levels per octave of the pyramid as loaded
+ */
+static void restore(Model& model, const vectorMat& filters, int nscales) {
+	model.setNScales(nscales);
+	model.filters().resize(filters.size());
+	for (size_t n = 0; n < filters.size(); ++n) filters[n].copyTo(model.filters()[n]);
+}
+
+/*! @brief detect over the dataset with one configuration, timing each image */
+template<typename T>
+static void run(Model& model, const Configuration& configuration, const vectorMat& images, const Options& options,
+		DatasetDetections& detections, vector<double>& latency) {
+
+	model.setNScales(configuration.interval);
+	PartsBasedDetector<T> pbd;
+	pbd.distributeModel(model);
+	pbd.setFixedPoint(configuration.fixed);
+	pbd.setPruning(configuration.pruning);
+	pbd.setRootSuppression(configuration.window, configuration.topk);
+	pbd.setReducedTree(configuration.height, configuration.depth);
+
+	// the detector itself parallelizes each image, so the images are timed one at a time
+	detections.resize(images.size());
+	latency.resize(images.size());
+	for (size_t i = 0; i < images.size(); ++i) {
+		vectorCandidate candidates;
+		const int64 ticks = getTickCount();
+		pbd.detect(images[i], candidates);
+		Candidate::nonMaximaSuppression(candidates, options.nms);
+		latency[i] = (getTickCount() - ticks) / getTickFrequency();
+		keypoints(candidates, options.keypoints, detections[i]);
+	}
+}
+
+/*! @brief mark the results that no other result is both faster and more accurate than */
+static void pareto(vector<Result>& results, const string& metric) {
+	for (size_t n = 0; n < results.size(); ++n) {
+		results[n].optimal = true;
+		for (size_t m = 0; m < results.size() && results[n].optimal; ++m) {
+			const double a = results[m].accuracy(metric), b = results[n].accuracy(metric);
+			const bool dominates = results[m].latency <= results[n].latency && a >= b &&
+					(results[m].latency < results[n].latency || a > b);
+			if (dominates) results[n].optimal = false;
+		}
+	}
+}
+
+/*! @brief parse a comma separated list of integers */
+static bool parseInts(const string& arg, vectori& values) {
+	vector<string> items;
+	boost::split(items, arg, boost::is_any_of(","));
+	for (size_t n = 0; n < items.size(); ++n) {
+		char* end;
+		values.push_back(strtol(items[n].c_str(), &end, 10));
+		if (items[n].empty() || *end) return false;
+	}
+	return true;
+}
+
+/*! @brief parse a comma separated list of pairs, such as 3:100,5:50 */
+static bool parsePairs(const string& arg, vector<Point>& pairs) {
+	vector<string> items;
+	boost::split(items, arg, boost::is_any_of(","));
+	for (size_t n = 0; n < items.size(); ++n) {
+		int a, b;
+		if (sscanf(items[n].c_str(), "%d:%d", &a, &b) != 2 || a < 0 || b < 0) return false;
+		pairs.push_back(Point(a, b));
+	}
+	return true;
+}
+
+static void usage(void) {
+	printf("Usage: PartsBasedDetector_evaluation model_file annotations.yaml [options]\n"
+		"  model_file                an .xml, .yaml (or .mat) model, or synthetic:face or synthetic:person\n"
+		"  annotations.yaml          the ground truth keypoints of each image\n"
+		"  --detections file.yaml    evaluate precomputed detections instead of running the detector\n"
+		"  --keypoints P[,P...]      the model part of each ground truth keypoint (default all parts in order)\n"
+		"  --metric M                pck, apk or ap, the accuracy of the Pareto front (default pck)\n"
+		"  --threshold T             the keypoint distance threshold, as a fraction of scale (default 0.5)\n"
+		"  --overlap O               the box overlap of a true positive for ap (default 0.5)\n"
+		"  --nms O                   the overlap of non-maxima suppression (default 0.3)\n"
+		"  --thresh T                override the detection threshold of the model\n"
+		"  --output file.json        write the results to a file\n"
+		"the matrix of speed options, each a comma separated list of values to sweep:\n"
+		"  --precision P[,P...]      float, double (default float)\n"
+		"  --fixed B[,B...]          0 or 1, a fixed point dynamic program (default 0)\n"
+		"  --interval N[,N...]       the levels per octave of the pyramid (default the model's)\n"
+		"  --suppression W:K[,...]   the root suppression window and top k (default 0:0)\n"
+		"  --reduced H:D[,...]       the reduced tree height and depth (default 0:0)\n"
+		"  --pruning B[,B...]        0 or 1, upper bound pruning of the dynamic program (default 1)\n");
+}
+
+int main(int argc, char** argv) {
+
+	// check arguments
+	if (argc < 3) {
+		usage();
+		exit(-1);
+	}
+	Options options;
+	for (int n = 3; n < argc; ++n) {
+		const string arg(argv[n]);
+		if (n+1 >= argc || arg.compare(0, 2, "--") != 0) {
+			usage();
+			exit(-1);
+		}
+		const string value(argv[++n]);
+		bool ok = true;
+		if (arg == "--detections")       options.detections = value;
+		else if (arg == "--keypoints")   ok = parseInts(value, options.keypoints);
+		else if (arg == "--metric")      { options.metric = value; ok = value == "pck" || value == "apk" || value == "ap"; }
+		else if (arg == "--threshold")   options.threshold = atof(value.c_str());
+		else if (arg == "--overlap")     options.overlap = atof(value.c_str());
+		else if (arg == "--nms")         options.nms = atof(value.c_str());
+		else if (arg == "--thresh")      { options.thresh = atof(value.c_str()); options.setthresh = true; }
+		else if (arg == "--precision")   boost::split(options.precisions, value, boost::is_any_of(","));
+		else if (arg == "--fixed")       ok = parseInts(value, options.fixed);
+		else if (arg == "--interval")    ok = parseInts(value, options.intervals);
+		else if (arg == "--suppression") ok = parsePairs(value, options.suppression);
+		else if (arg == "--reduced")     ok = parsePairs(value, options.reduced);
+		else if (arg == "--pruning")     ok = parseInts(value, options.pruning);
+		else if (arg == "--output") {
+			options.output = fopen(value.c_str(), "w");
+			if (!options.output) {
+				printf("Could not open %s for writing\n", value.c_str());
+				exit(-1);
+			}
+		}
+		else ok = false;
+		if (!ok) {
+			usage();
+			exit(-1);
+		}
+	}
+
+	// read the ground truth
+	vector<string> files;
+	DatasetAnnotations truth;
+	if (!readAnnotations(argv[2], files, truth)) {
+		printf("Error reading annotations %s\n", argv[2]);
+		exit(-2);
+	}
+
+	// evaluate precomputed detections
+	if (!options.detections.empty()) {
+		DatasetDetections detections;
+		if (!readDetections(options.detections, detections) || detections.size() != truth.size()) {
+			printf("Error reading detections %s, or they do not match the annotations\n", options.detections.c_str());
+			exit(-2);
+		}
+		Result result;
+		evaluate(detections, truth, options, result);
+		printf("pck %.4f  apk %.4f  ap %.4f\n", result.pck, result.apk, result.ap);
+		if (options.output) {
+			fprintf(options.output, "{\"pck\": %.6f, \"apk\": %.6f, \"ap\": %.6f}\n", result.pck, result.apk, result.ap);
+			fclose(options.output);
+		}
+		return 0;
+	}
+
+	// determine the type of model to read, or generate one
+	const string source(argv[1]);
+	boost::scoped_ptr<Model> model(loadModel(source));
+	if (!model) exit(-2);
+	if (!validKeypoints(*model, options.keypoints)) exit(-1);
+	if (options.setthresh) model->setThresh(options.thresh);
+	vectorMat filters(model->filters().size());
+	for (size_t n = 0; n < filters.size(); ++n) filters[n] = model->filters()[n].clone();
+	const int nscales = model->nscales();
+
+	// load the images
+	vectorMat images;
+	for (size_t n = 0; n < files.size(); ++n) {
+		Mat im = imread(files[n]);
+		if (im.empty()) {
+			printf("Image not found or invalid image format: %s\n", files[n].c_str());
+			exit(-4);
+		}
+		images.push_back(im);
+	}
+
+	// the matrix of speed options, defaulting to the baseline detector
+	if (options.precisions.empty()) options.precisions.push_back("float");
+	if (options.fixed.empty()) options.fixed.push_back(0);
+	if (options.intervals.empty()) options.intervals.push_back(nscales);
+	if (options.suppression.empty()) options.suppression.push_back(Point(0, 0));
+	if (options.reduced.empty()) options.reduced.push_back(Point(0, 0));
+	if (options.pruning.empty()) options.pruning.push_back(1);
+	vector<Configuration> configurations;
+	for (size_t p = 0; p < options.precisions.size(); ++p)
+	for (size_t f = 0; f < options.fixed.size(); ++f)
+	for (size_t i = 0; i < options.intervals.size(); ++i)
+	for (size_t s = 0; s < options.suppression.size(); ++s)
+	for (size_t r = 0; r < options.reduced.size(); ++r)
+	for (size_t u = 0; u < options.pruning.size(); ++u) {
+		Configuration c;
+		c.precision = options.precisions[p];
+		c.fixed = options.fixed[f] != 0;
+		c.interval = std::max(options.intervals[i], 1);
+		c.window = options.suppression[s].x;
+		c.topk = options.suppression[s].y;
+		c.height = options.reduced[r].x;
+		c.depth = options.reduced[r].y;
+		c.pruning = options.pruning[u] != 0;
+		configurations.push_back(c);
+	}
+
+	// run and evaluate each configuration
+	vector<Result> results;
+	for (size_t n = 0; n < configurations.size(); ++n) {
+		const Configuration& c = configurations[n];
+		DatasetDetections detections;
+		vector<double> latency;
+		restore(*model, filters, nscales);
+		if (c.precision == "float") run<float>(*model, c, images, options, detections, latency);
+		else if (c.precision == "double") run<double>(*model, c, images, options, detections, latency);
+		else {
+			fprintf(stderr, "Unknown precision %s\n", c.precision.c_str());
+			continue;
+		}
+		Result result;
+		result.configuration = c;
+		evaluate(detections, truth, options, result);
+		std::sort(latency.begin(), latency.end());
+		result.latency = mean(latency);
+		result.p95 = percentile(latency, 95);
+		result.detections = 0;
+		for (size_t i = 0; i < detections.size(); ++i) result.detections += detections[i].size();
+		results.push_back(result);
+		fprintf(stderr, "[%ld/%ld] %s\n", n+1, configurations.size(), c.label().c_str());
+	}
+
+	// the accuracy against latency, fastest first, with the Pareto front marked
+	pareto(results, options.metric);
+	std::sort(results.begin(), results.end(), faster);
+	printf("%-64s %10s %10s %8s %8s %8s %6s\n", "configuration", "mean ms", "p95 ms", "pck", "apk", "ap", "pareto");
+	for (size_t n = 0; n < results.size(); ++n) {
+		const Result& r = results[n];
+		printf("%-64s %10.3f %10.3f %8.4f %8.4f %8.4f %6s\n", r.configuration.label().c_str(),
+				r.latency * 1e3, r.p95 * 1e3, r.pck, r.apk, r.ap, r.optimal ? "*" : "");
+	}
+	if (options.output) {
+		FILE* out = options.output;
+		fprintf(out, "{\n  \"model\": \"%s\",\n  \"images\": %ld,\n  \"metric\": \"%s\",\n  \"results\": [",
+				model->name().c_str(), images.size(), options.metric.c_str());
+		for (size_t n = 0; n < results.size(); ++n) {
+			const Result& r = results[n];
+			const Configuration& c = r.configuration;
+			fprintf(out, "%s\n    {\"precision\": \"%s\", \"fixed\": %s, \"interval\": %d, \"suppression\": [%d, %d], \"reduced\": [%d, %d], \"pruning\": %s,\n",
+					n ? "," : "", c.precision.c_str(), c.fixed ? "true" : "false", c.interval, c.window, c.topk,
+					c.height, c.depth, c.pruning ? "true" : "false");
+			fprintf(out, "     \"latency\": {\"mean\": %.6f, \"p95\": %.6f}, \"pck\": %.6f, \"apk\": %.6f, \"ap\": %.6f, \"detections\": %ld, \"pareto\": %s}",
+					r.latency, r.p95, r.pck, r.apk, r.ap, r.detections, r.optimal ? "true" : "false");
+		}
+		fprintf(out, "\n  ]\n}\n");
+		fclose(out);
+	}
+	return 0;
+}
@@ -0,0 +1,126 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    FixedPointReport.cpp
+ *  Created: Oct 19, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <map>
+#include <string>
+#include <boost/filesystem.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include "PartsBasedDetector.hpp"
+#include "Candidate.hpp"
+#include "SyntheticModel.hpp"
+#include "types.hpp"
+using namespace cv;
+using namespace std;
+
+/*! @brief a candidate is identified by its component and root location */
+typedef vectori CandidateKey;
+
+static CandidateKey key(Candidate& candidate) {
+	const Rect& root = candidate.parts()[0];
+	const int values[] = { candidate.component(), root.x, root.y, root.width, root.height };
+	return CandidateKey(values, values + 5);
+}
+
+/*! @brief detect, returning the time taken in seconds */
+static double detect(PartsBasedDetector<double>& pbd, const Mat& im, vectorCandidate& candidates) {
+	candidates.clear();
+	double ticks = (double) getTickCount();
+	pbd.detect(im, candidates);
+	return ((double) getTickCount() - ticks) / getTickFrequency();
+}
+
+int main(int argc, char** argv) {
+
+	// check arguments
+	if (argc < 4) {
+		printf("Usage: FixedPointReport model_file scale image_file [image_file ...]\n");
+		exit(-1);
+	}
+
+	// determine the type of model to read, or generate one
+	boost::scoped_ptr<Model> model(loadModel(argv[1]));
+	if (!model) exit(-2);
+	const double scale = atof(argv[2]);
+
+	// the floating point path is the reference
+	PartsBasedDetector<double> pbd;
+	pbd.distributeModel(*model);
+
+	printf("fixed point scale %g\n", scale);
+	printf("%-32s %8s %8s %8s %8s %8s %12s %8s %8s\n", "image", "float", "fixed", "missing", "extra",
+			"moved", "score_err", "t_float", "t_fixed");
+	size_t total = 0, exact = 0;
+	double worst = 0;
+	for (int i = 3; i < argc; ++i) {
+		Mat im = imread(argv[i]);
+		if (im.empty()) {
+			printf("Skipping %s: image not found or invalid image format\n", argv[i]);
+			continue;
+		}
+
+		vectorCandidate reference, fixed;
+		pbd.setFixedPoint(false);
+		const double tfloat = detect(pbd, im, reference);
+		pbd.setFixedPoint(true, scale);
+		const double tfixed = detect(pbd, im, fixed);
+
+		// match the candidates by their root location
+		map<CandidateKey, size_t> index;
+		for (size_t n = 0; n < reference.size(); ++n) index[key(reference[n])] = n;
+		size_t matched = 0, moved = 0;
+		double error = 0;
+		for (size_t n = 0; n < fixed.size(); ++n) {
+			map<CandidateKey, size_t>::const_iterator it = index.find(key(fixed[n]));
+			if (it == index.end()) continue;
+			const Candidate& r = reference[it->second];
+			matched++;
+			error = std::max(error, (double)fabs(r.score() - fixed[n].score()));
+			if (r.parts() != fixed[n].parts()) moved++;
+		}
+
+		// candidates are missing or extra when rounding moves them across the threshold
+		printf("%-32s %8ld %8ld %8ld %8ld %8ld %12.6f %8.3f %8.3f\n", boost::filesystem::path(argv[i]).filename().string().c_str(),
+				reference.size(), fixed.size(), reference.size() - matched, fixed.size() - matched, moved, error, tfloat, tfixed);
+		total += reference.size();
+		exact += matched - moved;
+		worst  = std::max(worst, error);
+	}
+	printf("%ld of %ld candidates identical, max score error %.6f (quantization step %.6f)\n", exact, total, worst, 1.0 / scale);
+	return 0;
+}
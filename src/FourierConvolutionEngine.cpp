@@ -44,6 +44,8 @@
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include "FourierConvolutionEngine.hpp"
+#include "DetectionStats.hpp"
+#include "Trace.hpp"
 using namespace std;
 using namespace cv;
 
@@ -54,25 +56,44 @@ FourierConvolutionEngine::~FourierConvolutionEngine() {
 	// TODO Auto-generated destructor stub
 }
 
-void FourierConvolutionEngine::convolve(const Mat& feature, vectorMat& filter, Mat& pdf, const size_t channels) {
+/*! @brief Correlate a split feature with a filter in the frequency domain
+ *
+ * The response matches that of the SpatialConvolutionEngine: a correlation
+ * anchored at the centre of the filter, with the features padded by zeros,
+ * except the last (truncation) channel which is padded by ones. The features
+ * are placed at the anchor of the padded plane, so that the correlation does
+ * not wrap around as long as the plane is at least as large as the features
+ * plus the filter
+ *
+ * @param featurevec the feature, split into one plane per channel
+ * @param filter the spectra of the channels of the filter
+ * @param ksize the size of the filter, before padding
+ * @param pdf the response to return
+ * @param temp working storage for the accumulated spectrum
+ * @param padded working storage for the spectrum of a single channel
+ */
+void FourierConvolutionEngine::convolve(const vectorMat& featurevec, const vectorMat& filter, const Size& ksize, Mat& pdf, Mat& temp, Mat& padded) const {
 
   // error checking
-  assert(feature.depth() == type_);
-
-  // split the feature into separate channels
-  vectorMat featurevec;
-  split(feature.reshape(channels), featurevec);
+  const size_t channels = featurevec.size();
+  assert(channels == flen_ && featurevec[0].depth() == type_);
   Size size = featurevec[0].size();
+  assert(size.width + ksize.width - 1 <= size_.width && size.height + ksize.height - 1 <= size_.height);
+  const Point anchor(ksize.width/2, ksize.height/2);
   Rect valid(0, 0, size.width, size.height);
+  Rect placed(anchor.x, anchor.y, size.width, size.height);
 
-  // for each channel, convolve
-  Mat temp = Mat::zeros(size_, type_);
+  // for each channel, correlate
+  temp.create(size_, type_);
+  temp.setTo(Scalar::all(0));
   for (size_t c = 0; c < channels; ++c) {
-    Mat padded = Mat::zeros(size_, type_);
-    Mat corner(padded, valid);
+    const bool last = c == channels-1;
+    padded.create(size_, type_);
+    padded.setTo(Scalar::all(last ? 1 : 0));
+    Mat corner(padded, placed);
     featurevec[c].copyTo(corner);
-    dft(padded, padded, 0, size.height);
-    mulSpectrums(padded, filter[c], padded, 0);
+    dft(padded, padded, 0, last ? size_.height : placed.br().y);
+    mulSpectrums(padded, filter[c], padded, 0, true);
     temp += padded;
   }
   dft(temp, temp, DFT_INVERSE + DFT_SCALE, size.height);
@@ -87,25 +108,65 @@ void FourierConvolutionEngine::convolve(const Mat& feature, vectorMat& filter, M
  * (pdf) of part location
  * @param features the input features (at different scales, and by extension, size)
  * @param responses the vector of responses (pdfs) to return
+ * @param workspace the planes of the features at each scale, and a pair
+ * of spectra per thread
+ * @param deadline the deadline after which no more filters are applied
  */
-void FourierConvolutionEngine::pdf(const vectorMat& features, vector2DMat& responses) {
-  
+void FourierConvolutionEngine::pdf(const vectorMat& features, vector2DMat& responses, IConvolutionEngine::Workspace& workspace, const Deadline& deadline) const {
+
+  Workspace& ws = dynamic_cast<Workspace&>(workspace);
+
   // preallocate the output
   const size_t M = features.size();
   const size_t N = filters_.size();
   responses.resize(M, vectorMat(N));
+#ifdef _OPENMP
+  const size_t nthreads = omp_get_max_threads();
+#else
+  const size_t nthreads = 1;
+#endif
+
+  // split each feature into separate channels once, for all of the filters
+  ws.planes.resize(M);
+  ws.spectra.resize(2*nthreads);
+#ifdef _OPENMP
+  #pragma omp parallel for
+#endif
+  for (size_t m = 0; m < M; ++m) {
+    if (features[m].empty()) continue;
+    TRACE_SPAN("split", m);
+    split(features[m].reshape(flen_), ws.planes[m]);
+  }
 
-  // iterate
+  // iterate, timing each level on each thread
+  std::vector<int64> ticks(nthreads*M, 0);
 #ifdef _OPENMP
   #pragma omp parallel for
 #endif
   for (size_t n = 0; n < N; ++n) {
+#ifdef _OPENMP
+    const size_t t = omp_get_thread_num();
+#else
+    const size_t t = 0;
+#endif
     for (size_t m = 0; m < M; ++m) {
-      Mat response;
-      convolve(features[m], filters_[n], response, flen_);
-      responses[m][n] = response;
+      if (features[m].empty() || deadline.expired()) {
+        responses[m][n] = Mat();
+        continue;
+      }
+      TRACE_SPAN("convolve", m, n);
+      const int64 start = getTickCount();
+      convolve(ws.planes[m], filters_[n], sizes_[n], responses[m][n], ws.spectra[2*t], ws.spectra[2*t+1]);
+      ticks[t*M+m] += getTickCount() - start;
     }
   }
+  ws.level_seconds.assign(M, 0);
+  ws.thread_seconds.assign(nthreads, 0);
+  for (size_t t = 0; t < nthreads; ++t) {
+    for (size_t m = 0; m < M; ++m) ws.level_seconds[m] += ticks[t*M+m] / getTickFrequency();
+    for (size_t m = 0; m < M; ++m) ws.thread_seconds[t] += ticks[t*M+m] / getTickFrequency();
+  }
+  if (deadline.bounded()) discardIncomplete(responses);
 }
 
 /*! @brief set the filters
@@ -121,6 +182,7 @@ void FourierConvolutionEngine::setFilters(const vectorMat& filters) {
   const size_t N = filters.size();
   filters_.clear();
   filters_.resize(N);
+  sizes_.resize(N);
 
   // iterate over the filters
   const size_t C = flen_;
@@ -135,5 +197,19 @@ void FourierConvolutionEngine::setFilters(const vectorMat& filters) {
       filtervec[c].copyTo(corner);
       dft(padded, filtervec[c], 0, filtervec[c].rows);
     }
+    filters_[n] = filtervec;
+    sizes_[n] = filters[n].reshape(C).size();
   }
 }
+
+/*! @brief create an empty workspace
+ */
+IConvolutionEngine::Workspace* FourierConvolutionEngine::createWorkspace(void) const {
+  return new Workspace;
+}
+
+/*! @brief the bytes held by the split features and spectra
+ */
+size_t FourierConvolutionEngine::Workspace::bytes(void) const {
+  return DetectionStats::Memory::size(planes) + DetectionStats::Memory::size(spectra);
+}
@@ -44,6 +44,7 @@ inline double round(double x) { return (x > 0.0) ? floor(x + 0.5) : ceil(x - 0.5
 #endif
 #include <cassert>
 #include "HOGFeatures.hpp"
+#include "Trace.hpp"
 using namespace std;
 using namespace cv;
 
@@ -90,64 +91,94 @@ void HOGFeatures<T>::boundaryOcclusionFeature(Mat& feature, const int flen, cons
  * @param im the input image at native resolution
  * @param pyrafeatures the pyramid of features, fine to coarse, each
  * calculated via features()
+ * @param scales the size of a feature cell at each level, in pixels of the input image
+ * @param deadline levels which have not been started when the deadline
+ * expires are left empty
  */
 template<typename T>
-void HOGFeatures<T>::pyramid(const Mat& im, vectorMat& pyrafeatures) {
+void HOGFeatures<T>::pyramid(const Mat& im, vectorMat& pyrafeatures, vectorf& scales, const Deadline& deadline) const {
 
+	TRACE_SPAN("pyramid");
+	vectorMat pyraimages;
+	scalePyramid(im, pyraimages, scales);
+	const size_t nlevels = pyraimages.size();
+	pyrafeatures.clear();
+	pyrafeatures.resize(nlevels);
+
+	// perform the actual feature computation, in parallel if possible
+	#ifdef _OPENMP
+	#pragma omp parallel for
+	#endif
+	for (size_t n = 0; n < nlevels; ++n) {
+		if (deadline.expired()) continue;
+		TRACE_SPAN("features", n);
+		levelFeatures(pyraimages[n], pyrafeatures[n]);
+	}
+}
+
+/*! @brief Calculate the images of the pyramid
+ *
+ * The image is resized to each of the non-power of two scales,
+ * then progressively downsampled by powers of two
+ *
+ * @param im the input image at native resolution
+ * @param pyraimages the pyramid of images, fine to coarse
+ * @param scales the size of a feature cell at each level, in pixels of the input image
+ */
+template<typename T>
+void HOGFeatures<T>::scalePyramid(const Mat& im, vectorMat& pyraimages, vectorf& scales) const {
+
+	TRACE_SPAN("scalePyramid");
 	// calculate the scaling factor
 	Size_<float> imsize = im.size();
-	nscales_  = 1 + floor(log(min(imsize.height, imsize.width)/(5.0f*(float)binsize_))/log(sfactor_));
+	const size_t nlevels = 1 + floor(log(min(imsize.height, imsize.width)/(5.0f*(float)binsize_))/log(sfactor_));
 
-	vectorMat pyraimages;
-	pyraimages.resize(nscales_);
-	pyrafeatures.clear();
-	pyrafeatures.resize(nscales_);
-	pyraimages.resize(nscales_);
-	scales_.clear();
-	scales_.resize(nscales_);
+	// the images are resized into the existing levels, so that their storage is reused
+	pyraimages.resize(nlevels);
+	scales.resize(nlevels);
 
 	// perform the non-power of two scaling
 	// TODO: is this the most intuitive way to represent scaling?
+	const size_t ninterval = min(interval_, nlevels);
 	#ifdef _OPENMP
 	#pragma omp parallel for
 	#endif
-	for (size_t i = 0; i < interval_; ++i) {
-		Mat scaled;
-		resize(im, scaled, imsize * (float) (1.0f/pow(sfactor_,(int)i)));
-		pyraimages[i] = scaled;
-		scales_[i] = pow(sfactor_,(int)i)*binsize_;
+	for (size_t i = 0; i < ninterval; ++i) {
+		resize(im, pyraimages[i], imsize * (float) (1.0f/pow(sfactor_,(int)i)));
+		scales[i] = pow(sfactor_,(int)i)*binsize_;
 		// perform subsequent power of two scaling
-		for (size_t j = i+interval_; j < nscales_; j+=interval_) {
-			Mat scaled2;
-			pyrDown(scaled, scaled2);
-			pyraimages[j] = scaled2;
-			scales_[j] = 2 * scales_[j-interval_];
-			scaled2.copyTo(scaled);
+		for (size_t j = i+interval_; j < nlevels; j+=interval_) {
+			pyrDown(pyraimages[j-interval_], pyraimages[j]);
+			scales[j] = 2 * scales[j-interval_];
 		}
 	}
+}
 
-	// perform the actual feature computation, in parallel if possible
-	#ifdef _OPENMP
-	#pragma omp parallel for
-	#endif
-	for (size_t n = 0; n < nscales_; ++n) {
-		Mat feature;
-		Mat padded;
-		switch (im.depth()) {
-			case CV_32F: features<float>(pyraimages[n], feature); break;
-			case CV_64F: features<double>(pyraimages[n], feature); break;
-			case CV_8U:  features<uint8_t>(pyraimages[n], feature); break;
-			case CV_16U: features<uint16_t>(pyraimages[n], feature); break;
+/*! @brief compute the features of a single level of the pyramid
+ *
+ * @param im the image of the level
+ * @param feature the output features, of type T
+ * @param scratch the orientation histograms and block energies of the level
+ */
+template<typename T>
+void HOGFeatures<T>::levelFeatures(const Mat& im, Mat& feature, vectorMat& scratch) const {
+
+	scratch.resize(2);
+	Mat& hist = scratch[0];
+	Mat& norm = scratch[1];
+	switch (im.depth()) {
+		case CV_32F: features<float>(im, feature, hist, norm); break;
+		case CV_64F: features<double>(im, feature, hist, norm); break;
+		case CV_8U:  features<uint8_t>(im, feature, hist, norm); break;
+		case CV_16U: features<uint16_t>(im, feature, hist, norm); break;
 #if (CV_MAJOR_VERSION < 3)
-			default: CV_Error(CV_StsUnsupportedFormat, "Unsupported image type"); break;
+		default: CV_Error(CV_StsUnsupportedFormat, "Unsupported image type"); break;
 #else
-			default: CV_Error(cv::Error::StsUnsupportedFormat, "Unsupported image type"); break;
+		default: CV_Error(cv::Error::StsUnsupportedFormat, "Unsupported image type"); break;
 #endif
-		}
-		//copyMakeBorder(feature, padded, 3, 3, 3*flen_, 3*flen_, BORDER_CONSTANT, 0);
-		//boundaryOcclusionFeature(padded, flen_, 3);
-		pyrafeatures[n] = feature;
 	}
+	//copyMakeBorder(feature, padded, 3, 3, 3*flen_, 3*flen_, BORDER_CONSTANT, 0);
+	//boundaryOcclusionFeature(padded, flen_, 3);
 }
 
 /*! @brief compute the HOG features for an image
@@ -163,9 +194,11 @@ void HOGFeatures<T>::pyramid(const Mat& im, vectorMat& pyrafeatures) {
  *
  * @param imm the input image (must be color of type CV_8UC3)
  * @param featm the HOG features as a 2D matrix
+ * @param histm working storage for the orientation histograms
+ * @param normm working storage for the block energies
  */
 template<typename T> template<typename IT>
-void HOGFeatures<T>::features(const Mat& imm, Mat& featm) const {
+void HOGFeatures<T>::features(const Mat& imm, Mat& featm, Mat& histm, Mat& normm) const {
 
 	// compute the size of the output matrix
 	assert(imm.channels() == 1 || imm.channels() == 3);
@@ -175,9 +208,13 @@ void HOGFeatures<T>::features(const Mat& imm, Mat& featm) const {
 	const Size outsize = Size(max(blocks.width-2, 0), max(blocks.height-2, 0));
 	const Size visible = blocks*(int)binsize_;
 
-	Mat histm = Mat::zeros(Size(blocks.width*norient_, blocks.height),  DataType<T>::type);
-	Mat normm = Mat::zeros(Size(blocks.width,          blocks.height),  DataType<T>::type);
-	featm     = Mat::zeros(Size(outsize.width*flen_,   outsize.height), DataType<T>::type);
+	// the buffers are only reallocated if the size of the level has changed
+	histm.create(Size(blocks.width*norient_, blocks.height),  DataType<T>::type);
+	normm.create(Size(blocks.width,          blocks.height),  DataType<T>::type);
+	featm.create(Size(outsize.width*flen_,   outsize.height), DataType<T>::type);
+	histm.setTo(Scalar::all(0));
+	normm.setTo(Scalar::all(0));
+	featm.setTo(Scalar::all(0));
 
 	// get the stride of each of the matrices
 	const size_t imstride   = imm.step1();
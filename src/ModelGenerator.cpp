@@ -0,0 +1,113 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    ModelGenerator.cpp
+ *  Created: Oct 19, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+#include "SyntheticModel.hpp"
+using namespace std;
+
+static bool parseSize(const string& arg, cv::Size& size) {
+	return sscanf(arg.c_str(), "%dx%d", &size.width, &size.height) == 2 && size.width > 0 && size.height > 0;
+}
+
+static void usage(void) {
+	cerr << "Usage: ModelGenerator /path/to/xml/or/yaml/file [options]\n"
+		"  --preset P           face (13 components of 68 parts) or person (26 parts of\n"
+		"                       6 mixtures). Later options override the preset\n"
+		"  --name S             the name of the model\n"
+		"  --components N       the number of components (default 1)\n"
+		"  --parts N            the number of parts per component (default 26)\n"
+		"  --mixtures N         the number of mixtures per part (default 1)\n"
+		"  --rootsize WxH       the size of the root filters, in cells (default 5x5)\n"
+		"  --partsize WxH       the size of the part filters, in cells (default 5x5)\n"
+		"  --tree T             star, chain, binary or random (default random)\n"
+		"  --binsize N          the size of a feature cell, in pixels (default 4)\n"
+		"  --interval N         the levels per octave of the pyramid (default 5)\n"
+		"  --flen N             the length of the feature vector (default 32)\n"
+		"  --thresh T           the detection threshold (default -1)\n"
+		"  --seed S             the seed of the random weights (default 0)" << endl;
+}
+
+int main(int argc, char** argv) {
+
+	// check for usage
+	if (argc < 2) {
+		usage();
+		exit(-1);
+	}
+	SyntheticModel::Parameters params;
+	for (int n = 2; n < argc; ++n) {
+		const string arg(argv[n]);
+		if (n+1 >= argc) { usage(); exit(-1); }
+		const string value(argv[++n]);
+		bool ok = true;
+		if (arg == "--preset") {
+			if (value == "face") params = SyntheticModel::face();
+			else if (value == "person") params = SyntheticModel::person();
+			else ok = false;
+		}
+		else if (arg == "--name")       params.name = value;
+		else if (arg == "--components") params.ncomponents = atoi(value.c_str());
+		else if (arg == "--parts")      params.nparts = atoi(value.c_str());
+		else if (arg == "--mixtures")   params.nmixtures = atoi(value.c_str());
+		else if (arg == "--rootsize")   ok = parseSize(value, params.rootsize);
+		else if (arg == "--partsize")   ok = parseSize(value, params.partsize);
+		else if (arg == "--tree")       ok = SyntheticModel::parseTree(value, params.tree);
+		else if (arg == "--binsize")    params.binsize = atoi(value.c_str());
+		else if (arg == "--interval")   params.interval = atoi(value.c_str());
+		else if (arg == "--flen")       params.flen = atoi(value.c_str());
+		else if (arg == "--thresh")     params.thresh = atof(value.c_str());
+		else if (arg == "--seed")       params.seed = atoi(value.c_str());
+		else ok = false;
+		if (!ok) {
+			usage();
+			exit(-1);
+		}
+	}
+
+	// generate and serialize the model
+	SyntheticModel model(params);
+	if (!model.serialize(argv[1])) {
+		cerr << "Could not write " << argv[1] << endl;
+		exit(-2);
+	}
+	cout << "Wrote " << model.name() << " to " << argv[1] << ": " << model.ncomponents() << " components of "
+		 << params.nparts << " parts with " << params.nmixtures << " mixtures (" << model.filters().size() << " filters)" << endl;
+	return 0;
+}
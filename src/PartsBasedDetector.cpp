@@ -36,13 +36,34 @@
  *  Created: Jun 21, 2012
  */
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "PartsBasedDetector.hpp"
 #include "nms.hpp"
 #include "HOGFeatures.hpp"
 #include "SpatialConvolutionEngine.hpp"
+#include "Trace.hpp"
 using namespace cv;
 using namespace std;
 
+/*! @brief account the buffers of each level of a pyramid to a stage
+ *
+ * @param memory the accounts of the call
+ * @param stage the stage which created the buffers
+ * @param levels the buffers of each level
+ */
+template<typename U>
+static void allocateLevels(DetectionStats::Memory& memory, DetectionStats::Stage stage, const std::vector<U>& levels) {
+	for (size_t n = 0; n < levels.size(); ++n) memory.allocate(stage, n, -1, DetectionStats::Memory::size(levels[n]));
+}
+
+/*! @brief account the release of the buffers of each level of a pyramid, as allocateLevels() */
+template<typename U>
+static void releaseLevels(DetectionStats::Memory& memory, DetectionStats::Stage stage, const std::vector<U>& levels) {
+	for (size_t n = 0; n < levels.size(); ++n) memory.release(stage, n, -1, DetectionStats::Memory::size(levels[n]));
+}
+
 /*! @brief search an image for potential candidates
  *
  * calls detect(const Mat& im, const Mat&depth=Mat(), vector<Candidate>& candidates);
@@ -51,7 +72,7 @@ using namespace std;
  * @param candidates the output vector of detection candidates above the threshold
  */
 template<typename T>
-void PartsBasedDetector<T>::detect(const cv::Mat& im, vectorCandidate& candidates) {
+void PartsBasedDetector<T>::detect(const cv::Mat& im, vectorCandidate& candidates) const {
 	detect(im, Mat(), candidates);
 }
 
@@ -66,32 +87,726 @@ void PartsBasedDetector<T>::detect(const cv::Mat& im, vectorCandidate& candidate
  * @param candidates the output vector of detection candidates above the threshold
  */
 template<typename T>
-void PartsBasedDetector<T>::detect(const Mat& im, const Mat& depth, vectorCandidate& candidates) {
+void PartsBasedDetector<T>::detect(const Mat& im, const Mat& depth, vectorCandidate& candidates) const {
+
+	Detections detections;
+	detect(im, depth, detections);
+	detections.toCandidates(candidates);
+
+	if (!depth.empty()) {
+		//ssp_.filterCandidatesByDepth(parts_, candidates, depth, 0.03);
+	}
+}
+
+/*! @brief search an image for potential object candidates
+ *
+ * As detect(), but the detections are returned in a structure-of-arrays
+ * buffer, which avoids allocating a Candidate per detection
+ *
+ * @param im the input color or grayscale image
+ * @param depth the image depth image (currently unused)
+ * @param detections the output detections above the threshold, appended to
+ */
+template<typename T>
+void PartsBasedDetector<T>::detect(const Mat& im, const Mat& depth, Detections& detections) const {
+	DetectionStats stats;
+	detect(im, detections, stats);
+}
+
+/*! @brief search an image for potential object candidates, and time each stage
+ *
+ * @param im the input color or grayscale image
+ * @param detections the output detections above the threshold, appended to
+ * @param stats the output timing and counters of the call
+ */
+template<typename T>
+void PartsBasedDetector<T>::detect(const Mat& im, Detections& detections, DetectionStats& stats) const {
+
+	if (stream_levels_ > 0) {
+		stream(im, detections, stats);
+		return;
+	}
+
+	DetectionWorkspace workspace(false);
+	detect(im, workspace, detections);
+	stats = workspace.stats;
+}
+
+/*! @brief search an image for potential object candidates, reusing a workspace
+ *
+ * As detect(), but the buffers of each stage are kept in the workspace. Repeated
+ * calls with images of the same size reuse the buffers of the previous call rather
+ * than allocating them again. The timing and counters of the call are left in
+ * workspace.stats
+ *
+ * @param im the input color or grayscale image
+ * @param workspace the buffers of each stage, kept between calls
+ * @param detections the output detections above the threshold, appended to
+ */
+template<typename T>
+void PartsBasedDetector<T>::detect(const Mat& im, DetectionWorkspace& workspace, Detections& detections) const {
 
-	// calculate a feature pyramid for the new image
-	vectorMat pyramid;
-	features_->pyramid(im, pyramid);
+	const size_t before = detections.size();
+	workspace.stats.clear();
 
-	// convolve the feature pyramid with the Part experts
-	// to get probability density for each Part
-	vector2DMat pdf;
-	convolution_engine_->pdf(pyramid, pdf);
+	// calculate a feature pyramid for the new image, and convolve it
+	// with the Part experts to get probability density for each Part
+	responses(im, workspace);
 
 	// use dynamic programming to predict the best detection candidates from the part responses
-	vector4DMat Ix, Iy, Ik;
-	vector2DMat rootv, rooti;
-	dp_.min(parts_, pdf, Ix, Iy, Ik, rootv, rooti);
+	respond(workspace.pdf, workspace, detections, Deadline());
+	count(workspace, detections.size() - before, workspace.stats);
+}
+
+/*! @brief fill in the counters of the statistics of a call
+ *
+ * @param workspace the workspace of the call
+ * @param candidates the number of detections returned
+ * @param stats the statistics to fill in
+ */
+template<typename T>
+void PartsBasedDetector<T>::count(const DetectionWorkspace& workspace, size_t candidates, DetectionStats& stats) const {
+	stats.levels = workspace.scales.size();
+	stats.filters = workspace.pdf.empty() ? 0 : workspace.pdf[0].size();
+	stats.candidates = candidates;
+#ifdef _OPENMP
+	stats.threads = omp_get_max_threads();
+#else
+	stats.threads = 1;
+#endif
+	stats.bytes = workspace.bytes();
+}
+
+/*! @brief search a batch of images for potential object candidates
+ *
+ * As detect(), for each image of the batch
+ *
+ * @param images the input color or grayscale images
+ * @param candidates the output detection candidates of each image
+ */
+template<typename T>
+void PartsBasedDetector<T>::detect(const vectorMat& images, std::vector<vectorCandidate>& candidates) const {
+
+	std::vector<Detections> detections;
+	detect(images, detections);
+	candidates.resize(images.size());
+	for (size_t i = 0; i < images.size(); ++i) {
+		candidates[i].clear();
+		detections[i].toCandidates(candidates[i]);
+	}
+}
+
+/*! @brief search a batch of images for potential object candidates
+ *
+ * The pyramids of the images are concatenated, level by level, into a single
+ * pyramid. Each stage then runs once for the whole batch, so its parallel loop
+ * spans the levels of every image rather than those of one: the features
+ * of all levels, a single call to the convolution engine, and a single task graph
+ * of the dynamic program over every level and component of every image. This
+ * keeps every thread busy even for small images or single component models,
+ * where a single image has too little work for each stage
+ *
+ * Memory grows with the size of the batch, so very large collections should be
+ * passed a batch of a few times the number of threads at a time. If streaming is
+ * enabled (setStreaming()), the images are searched one at a time instead
+ *
+ * @param images the input color or grayscale images
+ * @param detections the output detections above the threshold of each image, appended to
+ */
+template<typename T>
+void PartsBasedDetector<T>::detect(const vectorMat& images, std::vector<Detections>& detections) const {
+
+	const size_t nimages = images.size();
+	detections.resize(nimages);
+	if (stream_levels_ > 0) {
+		DetectionStats stats;
+		for (size_t i = 0; i < nimages; ++i) stream(images[i], detections[i], stats);
+		return;
+	}
+
+	// the pyramid images of each image
+	std::vector<vectorMat> pyraimages(nimages);
+	std::vector<vectorf> scales(nimages);
+	#ifdef _OPENMP
+	#pragma omp parallel for schedule(dynamic)
+	#endif
+	for (size_t i = 0; i < nimages; ++i) {
+		features_->scalePyramid(images[i], pyraimages[i], scales[i]);
+	}
+
+	// concatenate the pyramids, so the levels of image i are [offsets[i], offsets[i+1])
+	std::vector<size_t> offsets(nimages+1, 0);
+	for (size_t i = 0; i < nimages; ++i) offsets[i+1] = offsets[i] + pyraimages[i].size();
+	const size_t nlevels = offsets[nimages];
+	DetectionWorkspace workspace(false);
+	workspace.pyraimages.resize(nlevels);
+	workspace.scales.resize(nlevels);
+	for (size_t i = 0; i < nimages; ++i) {
+		for (size_t n = 0; n < pyraimages[i].size(); ++n) {
+			workspace.pyraimages[offsets[i]+n] = pyraimages[i][n];
+			workspace.scales[offsets[i]+n] = scales[i][n];
+		}
+	}
+	pyraimages.clear();
+
+	// the features of every level of every image
+	workspace.features.resize(nlevels);
+	workspace.features_scratch.resize(nlevels);
+	#ifdef _OPENMP
+	#pragma omp parallel for schedule(dynamic)
+	#endif
+	for (size_t n = 0; n < nlevels; ++n) {
+		features_->levelFeatures(workspace.pyraimages[n], workspace.features[n], workspace.features_scratch[n]);
+		workspace.pyraimages[n].release();
+		workspace.features_scratch[n].clear();
+	}
+
+	// the part responses of every level, in a single pass over the filters
+	workspace.convolution = acquireConvolution();
+	convolution_engine_->pdf(workspace.features, workspace.pdf, *workspace.convolution);
+	releaseConvolution(workspace.convolution);
+	workspace.features.clear();
+
+	if (fixed_point_) {
+		quantize(workspace.pdf, workspace.quantized, fixed_dp_.scale());
+		workspace.pdf.clear();
+		solveBatch(fixed_dp_, fixed_plan_, workspace.quantized, workspace, offsets, detections);
+	} else {
+		solveBatch(dp_, plan_, workspace.pdf, workspace, offsets, detections);
+	}
+}
+
+/*! @brief allocate the buffers of a workspace ahead of the first image
+ *
+ * A blank image of the given size is searched with pruning disabled, so that the
+ * buffers of every level and component are allocated. Images of that size can then
+ * be searched without allocating any matrices
+ *
+ * @param workspace the workspace to prepare
+ * @param size the size of the images which will be searched
+ */
+template<typename T>
+void PartsBasedDetector<T>::prepare(DetectionWorkspace& workspace, const Size& size) const {
+
+	Detections detections;
+	responses(Mat::zeros(size, CV_8UC3), workspace);
+	if (fixed_point_) {
+		DynamicProgram<int> dp(fixed_dp_);
+		dp.setPruning(false);
+		quantize(workspace.pdf, workspace.quantized, dp.scale());
+		solve(dp, fixed_plan_, workspace.quantized, workspace, detections, Deadline());
+	} else {
+		DynamicProgram<T> dp(dp_);
+		dp.setPruning(false);
+		solve(dp, plan_, workspace.pdf, workspace, detections, Deadline());
+	}
+}
+
+/*! @brief calculate the feature pyramid of an image, and the part responses
+ *
+ * @param im the input color or grayscale image
+ * @param workspace the workspace to hold the pyramid and the responses
+ */
+template<typename T>
+void PartsBasedDetector<T>::responses(const Mat& im, DetectionWorkspace& workspace) const {
+	featurePyramid(im, workspace);
+	convolve(workspace);
+}
+
+/*! @brief calculate the feature pyramid of an image
+ *
+ * @param im the input color or grayscale image
+ * @param workspace the workspace to hold the pyramid images, scales and features
+ */
+template<typename T>
+void PartsBasedDetector<T>::featurePyramid(const Mat& im, DetectionWorkspace& workspace) const {
+
+	DetectionStats& stats = workspace.stats;
+	{
+		StageTimer timer(stats, DetectionStats::PYRAMID);
+		features_->scalePyramid(im, workspace.pyraimages, workspace.scales);
+	}
+	allocateLevels(stats.memory, DetectionStats::PYRAMID, workspace.pyraimages);
+	StageTimer timer(stats, DetectionStats::FEATURES);
+	const size_t nscales = workspace.pyraimages.size();
+	workspace.features.resize(nscales);
+	workspace.features_scratch.resize(nscales);
+	stats.level_features.assign(nscales, 0);
+	std::vector<double>& busy = stats.thread_busy[DetectionStats::FEATURES];
+	#ifdef _OPENMP
+	busy.assign(omp_get_max_threads(), 0);
+	#pragma omp parallel for
+	#else
+	busy.assign(1, 0);
+	#endif
+	for (size_t n = 0; n < nscales; ++n) {
+		TRACE_SPAN("features", n);
+		const int64 start = getTickCount();
+		features_->levelFeatures(workspace.pyraimages[n], workspace.features[n], workspace.features_scratch[n]);
+		stats.level_features[n] = (getTickCount() - start) / getTickFrequency();
+		#ifdef _OPENMP
+		busy[omp_get_thread_num()] += stats.level_features[n];
+		#else
+		busy[0] += stats.level_features[n];
+		#endif
+	}
+	allocateLevels(stats.memory, DetectionStats::FEATURES, workspace.features);
+	allocateLevels(stats.memory, DetectionStats::FEATURES, workspace.features_scratch);
+}
+
+/*! @brief calculate the part responses of a feature pyramid
+ *
+ * @param workspace the workspace holding the features, and to hold the responses
+ */
+template<typename T>
+void PartsBasedDetector<T>::convolve(DetectionWorkspace& workspace) const {
+
+	StageTimer timer(workspace.stats, DetectionStats::CONVOLUTION);
+
+	// a workspace which is not retained only borrows the convolution buffers
+	if (!workspace.convolution) workspace.convolution = acquireConvolution();
+	convolution_engine_->pdf(workspace.features, workspace.pdf, *workspace.convolution);
+	workspace.stats.level_convolution = workspace.convolution->level_seconds;
+	workspace.stats.thread_busy[DetectionStats::CONVOLUTION] = workspace.convolution->thread_seconds;
+	allocateLevels(workspace.stats.memory, DetectionStats::CONVOLUTION, workspace.pdf);
+
+	// the buffers of a borrowed convolution workspace go back to the pool
+	const size_t engine = workspace.convolution->bytes();
+	workspace.stats.memory.allocate(DetectionStats::CONVOLUTION, -1, -1, engine);
+	if (!workspace.retain()) {
+		workspace.stats.memory.release(DetectionStats::CONVOLUTION, -1, -1, engine);
+		releaseConvolution(workspace.convolution);
+	}
+}
+
+/*! @brief take a convolution workspace from the pool, or create one if it is empty
+ *
+ * The pool lets detections without a workspace of their own reuse the filter
+ * engines of earlier detections, and is safe to use from concurrent detections
+ *
+ * @return the convolution workspace
+ */
+template<typename T>
+boost::shared_ptr<IConvolutionEngine::Workspace> PartsBasedDetector<T>::acquireConvolution(void) const {
+	{
+		boost::mutex::scoped_lock lock(convolution_mutex_);
+		if (!convolution_pool_.empty()) {
+			boost::shared_ptr<IConvolutionEngine::Workspace> workspace = convolution_pool_.back();
+			convolution_pool_.pop_back();
+			return workspace;
+		}
+	}
+	return boost::shared_ptr<IConvolutionEngine::Workspace>(convolution_engine_->createWorkspace());
+}
+
+/*! @brief return a convolution workspace to the pool
+ *
+ * @param workspace the convolution workspace, which is reset
+ */
+template<typename T>
+void PartsBasedDetector<T>::releaseConvolution(boost::shared_ptr<IConvolutionEngine::Workspace>& workspace) const {
+	if (!workspace) return;
+	boost::mutex::scoped_lock lock(convolution_mutex_);
+	convolution_pool_.push_back(workspace);
+	workspace.reset();
+}
+
+/*! @brief quantize the part responses for the fixed point dynamic program
+ *
+ * @param pdf the part responses, in the precision of the detector
+ * @param quantized the output responses, multiplied by the scale and rounded
+ * @param scale the fixed point scale
+ */
+template<typename T>
+void PartsBasedDetector<T>::quantize(const vector2DMat& pdf, vector2DMat& quantized, double scale) {
+
+	quantized.resize(pdf.size());
+	for (size_t n = 0; n < pdf.size(); ++n) {
+		quantized[n].resize(pdf[n].size());
+		for (size_t k = 0; k < pdf[n].size(); ++k) {
+			if (pdf[n][k].empty()) quantized[n][k] = Mat();
+			else pdf[n][k].convertTo(quantized[n][k], DataType<int>::type, scale);
+		}
+	}
+}
+
+/*! @brief search an image for potential object candidates, a few levels at a time
+ *
+ * The pyramid is processed in groups of setStreaming() levels, from finest to
+ * coarsest, so the detections are in the same order as a full pyramid search.
+ * The buffers of each group go out of scope before the next group begins
+ *
+ * @param im the input color or grayscale image
+ * @param detections the output detections above the threshold, appended to
+ * @param stats the output timing and counters, summed over the groups
+ */
+template<typename T>
+void PartsBasedDetector<T>::stream(const Mat& im, Detections& detections, DetectionStats& stats) const {
+
+	const size_t before = detections.size();
+	stats.clear();
+	vectorMat pyraimages;
+	vectorf scales;
+	{
+		StageTimer timer(stats, DetectionStats::PYRAMID);
+		features_->scalePyramid(im, pyraimages, scales);
+	}
+	allocateLevels(stats.memory, DetectionStats::PYRAMID, pyraimages);
+	const size_t nscales = pyraimages.size();
+	stats.level_features.assign(nscales, 0);
+	stats.level_convolution.assign(nscales, 0);
+	std::vector<double>& features_busy = stats.thread_busy[DetectionStats::FEATURES];
+	std::vector<double>& convolution_busy = stats.thread_busy[DetectionStats::CONVOLUTION];
+#ifdef _OPENMP
+	features_busy.assign(omp_get_max_threads(), 0);
+#else
+	features_busy.assign(1, 0);
+#endif
+	boost::shared_ptr<IConvolutionEngine::Workspace> convolution = acquireConvolution();
+	size_t engine = 0;
+
+	for (size_t begin = 0; begin < nscales; begin += stream_levels_) {
+		const size_t end = std::min(begin + stream_levels_, nscales);
+
+		// the features of this group of levels alone
+		vectorMat pyramid(nscales);
+		{
+			StageTimer timer(stats, DetectionStats::FEATURES);
+			#ifdef _OPENMP
+			#pragma omp parallel for
+			#endif
+			for (size_t n = begin; n < end; ++n) {
+				const int64 start = getTickCount();
+				features_->levelFeatures(pyraimages[n], pyramid[n]);
+				stats.memory.release(DetectionStats::PYRAMID, n, -1, DetectionStats::Memory::size(pyraimages[n]));
+				pyraimages[n].release();
+				stats.level_features[n] = (getTickCount() - start) / getTickFrequency();
+				#ifdef _OPENMP
+				features_busy[omp_get_thread_num()] += stats.level_features[n];
+				#else
+				features_busy[0] += stats.level_features[n];
+				#endif
+			}
+		}
+
+		vector2DMat pdf;
+		{
+			StageTimer timer(stats, DetectionStats::CONVOLUTION);
+			convolution_engine_->pdf(pyramid, pdf, *convolution);
+			for (size_t n = begin; n < end; ++n) stats.level_convolution[n] = convolution->level_seconds[n];
+			const std::vector<double>& seconds = convolution->thread_seconds;
+			if (convolution_busy.size() < seconds.size()) convolution_busy.resize(seconds.size(), 0);
+			for (size_t t = 0; t < seconds.size(); ++t) convolution_busy[t] += seconds[t];
+		}
+		allocateLevels(stats.memory, DetectionStats::FEATURES, pyramid);
+		allocateLevels(stats.memory, DetectionStats::CONVOLUTION, pdf);
+		stats.memory.release(DetectionStats::CONVOLUTION, -1, -1, engine);
+		engine = convolution->bytes();
+		stats.memory.allocate(DetectionStats::CONVOLUTION, -1, -1, engine);
+		releaseLevels(stats.memory, DetectionStats::FEATURES, pyramid);
+		pyramid.clear();
+
+		// the accounts run on through the dynamic program of the group
+		DetectionWorkspace workspace(false);
+		workspace.scales = scales;
+		workspace.stats.memory = stats.memory;
+		respond(pdf, workspace, detections, Deadline());
+		stats.addStages(workspace.stats);
+		stats.memory = workspace.stats.memory;
+		stats.bytes = std::max(stats.bytes, workspace.bytes());
+		stats.filters = pdf.empty() ? 0 : pdf[0].size();
+
+		// the buffers of the group go out of scope
+		releaseLevels(stats.memory, DetectionStats::CONVOLUTION, pdf);
+		releaseLevels(stats.memory, DetectionStats::CONVOLUTION, workspace.quantized);
+		for (size_t n = 0; n < workspace.Ix.size(); ++n) {
+			for (size_t c = 0; c < workspace.Ix[n].size(); ++c) {
+				typedef DetectionStats::Memory M;
+				const size_t maps = M::size(workspace.Ix[n][c]) + M::size(workspace.Iy[n][c]) + M::size(workspace.Ik[n][c]) +
+						M::size(workspace.rootv[n][c]) + M::size(workspace.rooti[n][c]);
+				stats.memory.release(DetectionStats::DP, n, c, maps);
+			}
+		}
+	}
+	stats.memory.release(DetectionStats::CONVOLUTION, -1, -1, engine);
+	releaseConvolution(convolution);
+	stats.levels = nscales;
+	stats.candidates = detections.size() - before;
+#ifdef _OPENMP
+	stats.threads = omp_get_max_threads();
+#else
+	stats.threads = 1;
+#endif
+}
+
+/*! @brief search an image for potential object candidates within a deadline
+ *
+ * The levels of the pyramid are processed one at a time, from features through
+ * to backtracking, in the order given by setLevelOrder() (coarsest first by
+ * default). When the deadline expires, the detections of the levels which have
+ * been completed are returned, along with those of any components of the current
+ * level which were finished. Detections::covered() flags the completed levels.
+ * Root suppression (setRootSuppression()) is applied to each level as it is
+ * finished, so topk bounds the candidates of each level rather than of the call
+ *
+ * @param im the input color or grayscale image
+ * @param deadline the time by which the detections are needed
+ * @param detections the output detections above the threshold, appended to
+ */
+template<typename T>
+void PartsBasedDetector<T>::detect(const Mat& im, const Deadline& deadline, Detections& detections) const {
+
+	// the images of the pyramid are cheap relative to the features
+	vectorMat pyraimages;
+	vectorf scales;
+	features_->scalePyramid(im, pyraimages, scales);
+	const size_t nscales = pyraimages.size();
+	std::vector<bool> covered(nscales, false);
+	boost::shared_ptr<IConvolutionEngine::Workspace> convolution = acquireConvolution();
+
+	vectori order;
+	levelOrder(nscales, order);
+	for (size_t i = 0; i < order.size() && !deadline.expired(); ++i) {
+		const size_t n = order[i];
+
+		// the features and part responses of this level alone
+		vectorMat pyramid(nscales);
+		features_->levelFeatures(pyraimages[n], pyramid[n]);
+		vector2DMat pdf;
+		convolution_engine_->pdf(pyramid, pdf, *convolution, deadline);
+		if (pdf[n].empty() || pdf[n][0].empty()) break;
+
+		DetectionWorkspace workspace(false);
+		workspace.scales = scales;
+		covered[n] = respond(pdf, workspace, detections, deadline);
+	}
+	releaseConvolution(convolution);
+	detections.setCovered(covered);
+}
+
+/*! @brief the order in which to process the levels of the pyramid
+ *
+ * @param nscales the number of levels in the pyramid
+ * @param order the output order. The levels given to setLevelOrder() come first,
+ * followed by the remaining levels from coarsest to finest
+ */
+template<typename T>
+void PartsBasedDetector<T>::levelOrder(size_t nscales, vectori& order) const {
+	std::vector<bool> used(nscales, false);
+	order.clear();
+	for (size_t i = 0; i < level_order_.size(); ++i) {
+		const int n = level_order_[i];
+		if (n < 0 || n >= (int)nscales || used[n]) continue;
+		used[n] = true;
+		order.push_back(n);
+	}
+	for (int n = nscales-1; n >= 0; --n) {
+		if (!used[n]) order.push_back(n);
+	}
+}
+
+/*! @brief predict the best detection candidates from the part responses
+ *
+ * @param pdf the part responses, in the precision of the detector
+ * @param workspace the buffers of the dynamic program and backtracking
+ * @param detections the output detections above the threshold
+ * @param deadline the deadline after which no more components are started
+ * @return false if any components were skipped because the deadline expired
+ */
+template<typename T>
+bool PartsBasedDetector<T>::respond(vector2DMat& pdf, DetectionWorkspace& workspace, Detections& detections, const Deadline& deadline) const {
+
+	if (fixed_point_) {
+		quantize(pdf, workspace.quantized, fixed_dp_.scale());
+		allocateLevels(workspace.stats.memory, DetectionStats::CONVOLUTION, workspace.quantized);
+		return solve(fixed_dp_, fixed_plan_, workspace.quantized, workspace, detections, deadline);
+	}
+	return solve(dp_, plan_, pdf, workspace, detections, deadline);
+}
+
+/*! @brief run the dynamic program over the part responses of a workspace
+ *
+ * The first half of respond(), separated so that it can be pipelined
+ *
+ * @param workspace the part responses, and the buffers of the dynamic program
+ */
+template<typename T>
+void PartsBasedDetector<T>::minimize(DetectionWorkspace& workspace) const {
+
+	if (fixed_point_) {
+		quantize(workspace.pdf, workspace.quantized, fixed_dp_.scale());
+		allocateLevels(workspace.stats.memory, DetectionStats::CONVOLUTION, workspace.quantized);
+		minimize(fixed_dp_, fixed_plan_, workspace.quantized, workspace, Deadline());
+	} else {
+		minimize(dp_, plan_, workspace.pdf, workspace, Deadline());
+	}
+}
+
+/*! @brief suppress and backtrack the root scores of a workspace into detections
+ *
+ * The second half of respond(), separated so that it can be pipelined
+ *
+ * @param workspace the root scores and backtracking maps from minimize()
+ * @param detections the output detections above the threshold
+ */
+template<typename T>
+void PartsBasedDetector<T>::backtrack(DetectionWorkspace& workspace, Detections& detections) const {
+
+	if (fixed_point_) backtrack(fixed_dp_, fixed_plan_, workspace, detections);
+	else backtrack(dp_, plan_, workspace, detections);
+}
+
+/*! @brief predict the best detection candidates from the part responses
+ *
+ * @param dp the dynamic program, of either the detector or fixed point precision
+ * @param plan the compiled tree of parts, quantized for a fixed point dynamic program
+ * @param pdf the part responses, in the precision of the dynamic program
+ * @param workspace the buffers of the dynamic program and backtracking
+ * @param detections the output detections above the threshold
+ * @param deadline the deadline after which no more components are started
+ * @return false if any components were skipped because the deadline expired
+ */
+template<typename T> template<typename S>
+bool PartsBasedDetector<T>::solve(const DynamicProgram<S>& dp, const PartsPlan& plan, vector2DMat& pdf, DetectionWorkspace& workspace, Detections& detections, const Deadline& deadline) const {
+
+	const bool complete = minimize(dp, plan, pdf, workspace, deadline);
+	backtrack(dp, plan, workspace, detections);
+	return complete;
+}
+
+/*! @brief run the dynamic program over the part responses
+ *
+ * @param dp the dynamic program, of either the detector or fixed point precision
+ * @param plan the compiled tree of parts, quantized for a fixed point dynamic program
+ * @param pdf the part responses, in the precision of the dynamic program
+ * @param workspace the buffers of the dynamic program
+ * @param deadline the deadline after which no more components are started
+ * @return false if any components were skipped because the deadline expired
+ */
+template<typename T> template<typename S>
+bool PartsBasedDetector<T>::minimize(const DynamicProgram<S>& dp, const PartsPlan& plan, vector2DMat& pdf, DetectionWorkspace& workspace, const Deadline& deadline) const {
+
+	DetectionWorkspace& ws = workspace;
+	StageTimer timer(ws.stats, DetectionStats::DP);
+	reducedDepths(ws.scales, ws.maxdepth);
+	return ws.retain() ?
+		dp.min(plan, pdf, ws.Ix, ws.Iy, ws.Ik, ws.rootv, ws.rooti, ws.dp, ws.maxdepth, deadline, &ws.stats) :
+		dp.min(plan, pdf, ws.Ix, ws.Iy, ws.Ik, ws.rootv, ws.rooti, ws.maxdepth, deadline, &ws.stats);
+}
+
+/*! @brief suppress and backtrack the root scores into detections
+ *
+ * @param dp the dynamic program, of either the detector or fixed point precision
+ * @param plan the compiled tree of parts, quantized for a fixed point dynamic program
+ * @param workspace the root scores and backtracking maps of the dynamic program
+ * @param detections the output detections above the threshold
+ */
+template<typename T> template<typename S>
+void PartsBasedDetector<T>::backtrack(const DynamicProgram<S>& dp, const PartsPlan& plan, DetectionWorkspace& workspace, Detections& detections) const {
+
+	DetectionWorkspace& ws = workspace;
 
 	// suppress non-maximal candidates
-	//ssp_.nonMaxSuppression(rootv, features_->scales());
+	if (nms_window_ > 0 || topk_ > 0) {
+		StageTimer timer(ws.stats, DetectionStats::NMS);
+		ssp_.nonMaxSuppression(ws.rootv, dp.thresh()*dp.scale(), nms_window_, topk_, ws.nms);
+		allocateLevels(ws.stats.memory, DetectionStats::NMS, ws.nms.over);
+		allocateLevels(ws.stats.memory, DetectionStats::NMS, ws.nms.maxima);
+		allocateLevels(ws.stats.memory, DetectionStats::NMS, ws.nms.neighbours);
+	}
 
 	// walk back down the tree to find the part locations
-	dp_.argmin(parts_, rootv, rooti, features_->scales(), Ix, Iy, Ik, candidates);
+	TRACE_SPAN("backtrack");
+	StageTimer timer(ws.stats, DetectionStats::ARGMIN);
+	dp.argmin(plan, ws.rootv, ws.rooti, ws.scales, ws.Ix, ws.Iy, ws.Ik, detections, ws.maxdepth);
+}
 
-	if (!depth.empty()) {
-		//ssp_.filterCandidatesByDepth(parts_, candidates, depth, 0.03);
+/*! @brief predict the best detection candidates of a batch of images
+ *
+ * The dynamic program runs once across the concatenated pyramid. Root suppression
+ * and backtracking are applied to the levels of each image separately
+ *
+ * @param dp the dynamic program, of either the detector or fixed point precision
+ * @param plan the compiled tree of parts, quantized for a fixed point dynamic program
+ * @param pdf the part responses of the concatenated pyramid
+ * @param workspace the scales of the concatenated pyramid, and the buffers of the
+ * dynamic program and backtracking
+ * @param offsets the first level of each image in the concatenated pyramid, followed
+ * by the number of levels
+ * @param detections the output detections above the threshold of each image
+ */
+template<typename T> template<typename S>
+void PartsBasedDetector<T>::solveBatch(const DynamicProgram<S>& dp, const PartsPlan& plan, vector2DMat& pdf, DetectionWorkspace& workspace, const std::vector<size_t>& offsets, std::vector<Detections>& detections) const {
+
+	DetectionWorkspace& ws = workspace;
+	reducedDepths(ws.scales, ws.maxdepth);
+	dp.min(plan, pdf, ws.Ix, ws.Iy, ws.Ik, ws.rootv, ws.rooti, ws.maxdepth);
+
+	const size_t nimages = detections.size();
+	#ifdef _OPENMP
+	#pragma omp parallel for schedule(dynamic)
+	#endif
+	for (size_t i = 0; i < nimages; ++i) {
+		// the levels of this image alone. The matrices are shared, not copied
+		const size_t begin = offsets[i], end = offsets[i+1];
+		vector2DMat rootv(ws.rootv.begin()+begin, ws.rootv.begin()+end);
+		vector2DMat rooti(ws.rooti.begin()+begin, ws.rooti.begin()+end);
+		vector4DMat Ix(ws.Ix.begin()+begin, ws.Ix.begin()+end);
+		vector4DMat Iy(ws.Iy.begin()+begin, ws.Iy.begin()+end);
+		vector4DMat Ik(ws.Ik.begin()+begin, ws.Ik.begin()+end);
+		vectorf scales(ws.scales.begin()+begin, ws.scales.begin()+end);
+		vectori maxdepth;
+		if (!ws.maxdepth.empty()) maxdepth.assign(ws.maxdepth.begin()+begin, ws.maxdepth.begin()+end);
+
+		if (nms_window_ > 0 || topk_ > 0) ssp_.nonMaxSuppression(rootv, dp.thresh()*dp.scale(), nms_window_, topk_);
+		dp.argmin(plan, rootv, rooti, scales, Ix, Iy, Ik, detections[i], maxdepth);
+	}
+}
+
+/*! @brief run the dynamic program in fixed point
+ *
+ * The part responses are multiplied by the scale and rounded to int32 before the
+ * dynamic program, as are the deformation weights and biases. This halves the
+ * memory traffic of the distance transforms and reductions relative to double.
+ * Candidate scores are returned in the original units. Rounding may change the
+ * order of near-tied scores, see FixedPointReport for the difference to the
+ * floating point path on a set of images
+ *
+ * @param enable true to run the dynamic program in fixed point
+ * @param scale the fixed point scale. Scores must stay within +/- 2^30 / scale
+ */
+template<typename T>
+void PartsBasedDetector<T>::setFixedPoint(bool enable, double scale) {
+	fixed_point_ = enable;
+	fixed_plan_ = plan_.quantized(scale);
+	fixed_dp_ = DynamicProgram<int>(dp_.thresh(), dp_.pruning(), scale);
+}
+
+/*! @brief the depth of the tree to evaluate at each scale of the pyramid
+ *
+ * @param scales the size of a feature cell at each level of the pyramid
+ * @param maxdepth the output maximum depth at each scale, or empty if the full
+ * tree is evaluated at every scale
+ */
+template<typename T>
+void PartsBasedDetector<T>::reducedDepths(const vectorf& scales, vectori& maxdepth) const {
+
+	maxdepth.clear();
+	if (reduced_height_ <= 0) return;
+
+	// the tallest root filter, in cells
+	int rootheight = 0;
+	for (size_t c = 0; c < plan_.ncomponents(); ++c) {
+		const ComponentPlan& cplan = plan_.component(c);
+		for (size_t m = 0; m < cplan.nmixtures(0); ++m) {
+			rootheight = std::max(rootheight, cplan.size(0, m).height);
+		}
 	}
 
+	maxdepth.resize(scales.size(), -1);
+	for (size_t n = 0; n < scales.size(); ++n) {
+		if (rootheight * scales[n] < reduced_height_) maxdepth[n] = reduced_depth_;
+	}
 }
 
 /*! @brief Distribute the model parameters to the PartsBasedDetector classes
@@ -109,6 +824,7 @@ void PartsBasedDetector<T>::distributeModel(Model& model) {
 
 	//initialise the convolution engine
 	convolution_engine_.reset(new SpatialConvolutionEngine(DataType<T>::type, model.flen()));
+	convolution_pool_.clear();
 
 	// make sure the filters are of the correct precision for the Feature engine
 	const size_t nfilters = model.filters().size();
@@ -120,9 +836,11 @@ void PartsBasedDetector<T>::distributeModel(Model& model) {
 	// initialize the tree of Parts
 	parts_ = Parts(model.filters(), model.filtersi(), model.def(), model.defi(), model.bias(), model.biasi(),
 			model.anchors(), model.biasid(), model.filterid(), model.defid(), model.parentid());
+	plan_ = PartsPlan(parts_);
 
 	// initialize the dynamic program
 	dp_ = DynamicProgram<T>(model.thresh());
+	setFixedPoint(fixed_point_, fixed_dp_.scale());
 
 }
 
@@ -0,0 +1,149 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    PartsPlan.cpp
+ *  Created: Oct 19, 2026
+ */
+
+#include <cassert>
+#include "PartsPlan.hpp"
+using namespace cv;
+using namespace std;
+
+/*! @brief compile the plan for a single component
+ *
+ * @param parts the tree of parts
+ * @param c the component to compile
+ */
+ComponentPlan::ComponentPlan(Parts& parts, size_t c) {
+
+	const size_t nparts = parts.nparts(c);
+	parent_.resize(nparts);
+	depth_.resize(nparts);
+	mixoffset_.resize(nparts+1);
+	biasoffset_.resize(nparts);
+
+	// the tree structure. Parts are sorted from the root to the leaves
+	mixoffset_[0] = 0;
+	for (size_t p = 0; p < nparts; ++p) {
+		ComponentPart cpart = parts.component(c, p);
+		parent_[p] = cpart.isRoot() ? 0 : cpart.parent().self();
+		depth_[p]  = cpart.isRoot() ? 0 : depth_[parent_[p]] + 1;
+		mixoffset_[p+1] = mixoffset_[p] + cpart.nmixtures();
+	}
+
+	// the children of each part, in descending order
+	childoffset_.resize(nparts+1, 0);
+	for (size_t p = 1; p < nparts; ++p) childoffset_[parent_[p]+1]++;
+	for (size_t p = 0; p < nparts; ++p) childoffset_[p+1] += childoffset_[p];
+	children_.resize(childoffset_[nparts]);
+	vectori fill(childoffset_.begin(), childoffset_.end()-1);
+	for (int p = nparts-1; p > 0; --p) children_[fill[parent_[p]]++] = p;
+
+	// the per part-mixture parameters
+	const size_t nmixtures = mixoffset_[nparts];
+	filter_.resize(nmixtures);
+	defw_.resize(4*nmixtures);
+	anchor_.resize(nmixtures);
+	size_.resize(nmixtures);
+	for (size_t p = 0; p < nparts; ++p) {
+		ComponentPart cpart = parts.component(c, p);
+		for (size_t m = 0; m < cpart.nmixtures(); ++m) {
+			const size_t pm = mixoffset_[p] + m;
+			filter_[pm] = cpart.filterid(m);
+			anchor_[pm] = cpart.anchor(m);
+			size_[pm]   = Size(cpart.xsize(m), cpart.ysize(m));
+			vectorf w = cpart.defw(m);
+			for (size_t k = 0; k < 4 && k < w.size(); ++k) defw_[4*pm + k] = w[k];
+		}
+	}
+
+	// the bias matrix of each (child mixture, parent mixture) pair
+	for (size_t p = 0; p < nparts; ++p) {
+		biasoffset_[p] = bias_.size();
+		if (p == 0) continue;
+		ComponentPart cpart = parts.component(c, p);
+		const size_t pnmixtures = cpart.parent().nmixtures();
+		for (size_t mm = 0; mm < cpart.nmixtures(); ++mm) {
+			vectorf b = cpart.bias(mm);
+			assert(b.size() >= pnmixtures);
+			bias_.insert(bias_.end(), b.begin(), b.begin() + pnmixtures);
+		}
+	}
+	rootbias_ = parts.component(c).bias(0)[0];
+}
+
+/*! @brief quantize the weights of the plan for a fixed point dynamic program
+ *
+ * The deformation weights and biases are multiplied by the scale and rounded to
+ * the nearest integer. They remain stored as float, which represents integers
+ * exactly up to 2^24. A nonzero quadratic deformation weight is never rounded to
+ * zero, since the distance transform divides by it
+ *
+ * @param scale the fixed point scale
+ */
+void ComponentPlan::quantize(double scale) {
+	for (size_t k = 0; k < defw_.size(); ++k) {
+		const float w = cvRound(defw_[k] * scale);
+		// the quadratic terms are stored at offsets 0 and 2
+		if (k % 2 == 0 && w == 0 && defw_[k] != 0) defw_[k] = defw_[k] > 0 ? 1 : -1;
+		else defw_[k] = w;
+	}
+	for (size_t k = 0; k < bias_.size(); ++k) bias_[k] = cvRound(bias_[k] * scale);
+	rootbias_ = cvRound(rootbias_ * scale);
+}
+
+/*! @brief compile the plans for all components of a Parts tree
+ *
+ * @param parts the tree of parts
+ */
+PartsPlan::PartsPlan(Parts& parts) {
+	const size_t ncomponents = parts.ncomponents();
+	components_.reserve(ncomponents);
+	for (size_t c = 0; c < ncomponents; ++c) {
+		components_.push_back(ComponentPlan(parts, c));
+	}
+}
+
+/*! @brief a copy of the plan, quantized for a fixed point dynamic program
+ *
+ * @param scale the fixed point scale
+ * @return the quantized plan
+ */
+PartsPlan PartsPlan::quantized(double scale) const {
+	PartsPlan plan(*this);
+	for (size_t c = 0; c < plan.components_.size(); ++c) {
+		plan.components_[c].quantize(scale);
+	}
+	return plan;
+}
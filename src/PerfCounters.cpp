@@ -0,0 +1,251 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    PerfCounters.cpp
+ *  Created: Oct 19, 2026
+ */
+
+#include "PerfCounters.hpp"
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+#ifdef __linux__
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+namespace {
+	boost::atomic<bool> counters_enabled(false);
+	boost::mutex counters_mutex;
+
+#ifdef __linux__
+	//! the events counted, in the order of the fields of PerfCounts
+	const unsigned long long events[] = {
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES
+	};
+	const int nevents = sizeof(events) / sizeof(events[0]);
+
+	//! the counters of one thread, -1 where the event could not be opened
+	struct ThreadCounters {
+		unsigned long long start;
+		int fd[nevents];
+	};
+	std::map<pid_t, ThreadCounters> threads;
+
+	int openCounter(unsigned long long event, pid_t tid) {
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = event;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		return syscall(__NR_perf_event_open, &attr, tid, -1, -1, 0);
+	}
+
+	void closeCounters(ThreadCounters& counters) {
+		for (int e = 0; e < nevents; ++e) if (counters.fd[e] >= 0) close(counters.fd[e]);
+	}
+
+	/*! @brief the start time of a thread, field 22 of /proc/self/task/<tid>/stat
+	 *
+	 * @return the start time in clock ticks since boot, or 0 if the thread has exited
+	 */
+	unsigned long long startTime(pid_t tid) {
+		char path[64], line[1024];
+		snprintf(path, sizeof(path), "/proc/self/task/%d/stat", (int)tid);
+		FILE* stat = fopen(path, "r");
+		if (!stat) return 0;
+		const bool ok = fgets(line, sizeof(line), stat) != NULL;
+		fclose(stat);
+		// the name of the thread, field 2, is in parentheses and may contain spaces
+		const char* field = ok ? strrchr(line, ')') : NULL;
+		if (!field) return 0;
+		// skip to the start time, 20 fields after the name
+		for (int f = 0; f < 20 && field; ++f) field = strchr(field + 1, ' ');
+		return field ? strtoull(field + 1, NULL, 10) : 0;
+	}
+
+	/*! @brief bring the counters up to date with the threads of the process
+	 *
+	 * Opens the counters of threads which have started since the last call,
+	 * closes those of threads which have exited, and reopens those of a thread
+	 * id which now belongs to another thread
+	 */
+	void updateThreads(void) {
+		DIR* dir = opendir("/proc/self/task");
+		if (!dir) return;
+		std::set<pid_t> alive;
+		while (struct dirent* entry = readdir(dir)) {
+			if (entry->d_name[0] == '.') continue;
+			const pid_t tid = atoi(entry->d_name);
+			const unsigned long long start = startTime(tid);
+			if (start == 0) continue;
+			alive.insert(tid);
+			std::map<pid_t, ThreadCounters>::iterator it = threads.find(tid);
+			if (it != threads.end() && it->second.start == start) continue;
+			if (it != threads.end()) closeCounters(it->second);
+			ThreadCounters& counters = threads[tid];
+			counters.start = start;
+			for (int e = 0; e < nevents; ++e) counters.fd[e] = openCounter(events[e], tid);
+		}
+		closedir(dir);
+		for (std::map<pid_t, ThreadCounters>::iterator it = threads.begin(); it != threads.end(); ) {
+			if (alive.count(it->first)) {
+				++it;
+			} else {
+				closeCounters(it->second);
+				threads.erase(it++);
+			}
+		}
+	}
+
+	//! the scaled count of a counter, or 0 if it cannot be read
+	double readCounter(int fd) {
+		if (fd < 0) return 0;
+		unsigned long long value[3];
+		if (::read(fd, value, sizeof(value)) != sizeof(value) || value[2] == 0) return 0;
+		return (double)value[0] * value[1] / value[2];
+	}
+#endif
+}
+
+/*! @brief whether the counters can be read on this host
+ *
+ * @return true if a cycle counter could be opened for the calling thread
+ */
+bool PerfCounters::available(void) {
+#ifdef __linux__
+	static const int probe = openCounter(PERF_COUNT_HW_CPU_CYCLES, 0);
+	return probe >= 0;
+#else
+	return false;
+#endif
+}
+
+/*! @brief start or stop reading the counters around each stage
+ *
+ * @param enable true to read the counters
+ * @return whether the counters are now enabled, false if they are unavailable
+ */
+bool PerfCounters::enable(bool enable) {
+	counters_enabled = enable && available();
+	return counters_enabled;
+}
+
+//! whether the counters are read around each stage
+bool PerfCounters::enabled(void) {
+	return counters_enabled.load(boost::memory_order_relaxed);
+}
+
+/*! @brief the counts of every live thread of the process so far
+ *
+ * @param counts the output counts, summed over threads
+ * @param per_thread the output counts of each thread, in order of thread id, if not NULL
+ * @return false if the counters are unavailable
+ */
+bool PerfCounters::read(PerfCounts& counts, std::vector<ThreadPerfCounts>* per_thread) {
+	counts = PerfCounts();
+	if (per_thread) per_thread->clear();
+#ifdef __linux__
+	if (!available()) return false;
+	boost::mutex::scoped_lock lock(counters_mutex);
+	updateThreads();
+	for (std::map<pid_t, ThreadCounters>::const_iterator it = threads.begin(); it != threads.end(); ++it) {
+		ThreadPerfCounts thread;
+		thread.tid = it->first;
+		thread.start = it->second.start;
+		thread.counts.cycles        = readCounter(it->second.fd[0]);
+		thread.counts.instructions  = readCounter(it->second.fd[1]);
+		thread.counts.llc_misses    = readCounter(it->second.fd[2]);
+		thread.counts.branch_misses = readCounter(it->second.fd[3]);
+		counts += thread.counts;
+		if (per_thread) per_thread->push_back(thread);
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+/*! @brief the counts of each thread between two reads
+ *
+ * A thread which started after the first read counts from zero, and one which
+ * exited before the second is left out, so the total never goes backwards
+ *
+ * @param before the counts of each thread at the first read
+ * @param after the counts of each thread at the second read
+ * @param delta the output counts of each thread between the reads
+ * @param total the output counts between the reads, summed over threads
+ */
+void PerfCounters::difference(const std::vector<ThreadPerfCounts>& before, const std::vector<ThreadPerfCounts>& after,
+		std::vector<ThreadPerfCounts>& delta, PerfCounts& total) {
+	delta = after;
+	total = PerfCounts();
+	for (size_t n = 0; n < delta.size(); ++n) {
+		for (size_t m = 0; m < before.size(); ++m) {
+			if (before[m].same(delta[n])) {
+				delta[n].counts -= before[m].counts;
+				break;
+			}
+		}
+		total += delta[n].counts;
+	}
+}
+
+/*! @brief add the counts of each thread to those of the same thread
+ *
+ * @param into the counts of each thread to add to
+ * @param from the counts of each thread to add
+ */
+void PerfCounters::accumulate(std::vector<ThreadPerfCounts>& into, const std::vector<ThreadPerfCounts>& from) {
+	for (size_t n = 0; n < from.size(); ++n) {
+		size_t m = 0;
+		while (m < into.size() && !into[m].same(from[n])) ++m;
+		if (m == into.size()) {
+			into.push_back(from[n]);
+		} else {
+			into[m].counts += from[n].counts;
+		}
+	}
+}
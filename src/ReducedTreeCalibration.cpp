@@ -0,0 +1,171 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    ReducedTreeCalibration.cpp
+ *  Created: Oct 19, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+#include <string>
+#include <opencv2/highgui/highgui.hpp>
+#include "PartsBasedDetector.hpp"
+#include "Candidate.hpp"
+#include "Metrics.hpp"
+#include "SyntheticModel.hpp"
+#include "types.hpp"
+using namespace cv;
+using namespace std;
+
+/*! @brief detect and suppress overlapping candidates, returning the time taken in seconds */
+static double detect(PartsBasedDetector<float>& pbd, const Mat& im, vectorCandidate& candidates) {
+	candidates.clear();
+	double ticks = (double) getTickCount();
+	pbd.detect(im, candidates);
+	ticks = ((double) getTickCount() - ticks) / getTickFrequency();
+	Candidate::nonMaximaSuppression(candidates, 0.3);
+	return ticks;
+}
+
+/*! @brief accumulated agreement between the reduced and full tree detections */
+struct Agreement {
+	size_t reference;
+	size_t detected;
+	size_t matched;
+	double score;
+	double displacement;
+	double seconds;
+	Agreement() : reference(0), detected(0), matched(0), score(0), displacement(0), seconds(0) {}
+};
+
+/*! @brief match the reduced tree detections to the full tree detections
+ *
+ * Each full tree detection is greedily matched to the best overlapping
+ * unmatched reduced tree detection with an IoU of at least 0.5. For matched
+ * pairs, the root score difference and the mean part displacement (normalized
+ * by the height of the detection) are accumulated
+ */
+static void match(const vectorCandidate& full, const vectorCandidate& reduced, Agreement& agreement) {
+	std::vector<bool> used(reduced.size(), false);
+	agreement.reference += full.size();
+	agreement.detected  += reduced.size();
+	for (size_t i = 0; i < full.size(); ++i) {
+		const Rect bb = full[i].boundingBox();
+		double best = 0.5;
+		int bestj = -1;
+		for (size_t j = 0; j < reduced.size(); ++j) {
+			if (used[j]) continue;
+			const double o = Metrics::overlap(bb, reduced[j].boundingBox());
+			if (o >= best) { best = o; bestj = j; }
+		}
+		if (bestj < 0) continue;
+		used[bestj] = true;
+		agreement.matched++;
+		agreement.score += fabs(full[i].score() - reduced[bestj].score());
+		const vector<Rect>& fparts = full[i].parts();
+		const vector<Rect>& rparts = reduced[bestj].parts();
+		const size_t nparts = std::min(fparts.size(), rparts.size());
+		double displacement = 0;
+		for (size_t p = 0; p < nparts; ++p) {
+			const Point d = (fparts[p].tl() + fparts[p].br()) - (rparts[p].tl() + rparts[p].br());
+			displacement += 0.5 * sqrt((double)d.dot(d));
+		}
+		if (nparts > 0) agreement.displacement += displacement / nparts / std::max(bb.height, 1);
+	}
+}
+
+int main(int argc, char** argv) {
+
+	// check arguments
+	if (argc < 5) {
+		printf("Usage: ReducedTreeCalibration model_file image_list depth height [height ...]\n");
+		printf("  image_list  a text file with one validation image path per line\n");
+		printf("  depth       the depth of the reduced tree (the root has depth 0)\n");
+		printf("  height      the detection heights (pixels) below which the reduced tree is used\n");
+		exit(-1);
+	}
+
+	// determine the type of model to read, or generate one
+	boost::scoped_ptr<Model> model(loadModel(argv[1]));
+	if (!model) exit(-2);
+
+	// read the validation set
+	vector<string> images;
+	ifstream list(argv[2]);
+	for (string line; getline(list, line); ) {
+		if (!line.empty()) images.push_back(line);
+	}
+	if (images.empty()) {
+		printf("No images found in %s\n", argv[2]);
+		exit(-4);
+	}
+	const int depth = atoi(argv[3]);
+	vectori heights;
+	for (int i = 4; i < argc; ++i) heights.push_back(atoi(argv[i]));
+
+	// create the PartsBasedDetector and distribute the model parameters
+	PartsBasedDetector<float> pbd;
+	pbd.distributeModel(*model);
+
+	// the full tree is the reference
+	vector<Agreement> agreement(heights.size());
+	double reference = 0;
+	for (size_t n = 0; n < images.size(); ++n) {
+		Mat im = imread(images[n]);
+		if (im.empty()) {
+			printf("Skipping %s: image not found or invalid image format\n", images[n].c_str());
+			continue;
+		}
+		vectorCandidate full, reduced;
+		pbd.setReducedTree(0, depth);
+		reference += detect(pbd, im, full);
+		for (size_t h = 0; h < heights.size(); ++h) {
+			pbd.setReducedTree(heights[h], depth);
+			agreement[h].seconds += detect(pbd, im, reduced);
+			match(full, reduced, agreement[h]);
+		}
+	}
+
+	// report the accuracy and throughput at each height
+	printf("reduced tree depth %d, %ld images, full tree %.3fs\n", depth, images.size(), reference);
+	printf("%8s %8s %8s %8s %10s %12s %8s\n", "height", "recall", "extra", "speedup", "score_err", "displacement", "seconds");
+	for (size_t h = 0; h < heights.size(); ++h) {
+		const Agreement& a = agreement[h];
+		const double recall = a.reference ? (double)a.matched / a.reference : 1.0;
+		const double matched = std::max<double>(a.matched, 1);
+		printf("%8d %8.3f %8ld %8.2f %10.4f %12.4f %8.3f\n", heights[h], recall, a.detected - a.matched,
+				a.seconds > 0 ? reference / a.seconds : 0.0, a.score / matched, a.displacement / matched, a.seconds);
+	}
+	return 0;
+}
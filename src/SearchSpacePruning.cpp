@@ -36,13 +36,27 @@
  *  Created: Aug 1, 2012
  */
 
+#include <queue>
+#include <functional>
 #include "nms.hpp"
 #include "Candidate.hpp"
 #include "SearchSpacePruning.hpp"
+#include "Trace.hpp"
 #include "Math.hpp"
 using namespace cv;
 using namespace std;
 
+/*! @brief a root location, ordered by its score */
+template<typename T>
+struct RootLocation {
+	T score;
+	size_t n;
+	size_t c;
+	Point location;
+	RootLocation(T _score, size_t _n, size_t _c, Point _location) : score(_score), n(_n), c(_c), location(_location) {}
+	bool operator>(const RootLocation& other) const { return score > other.score; }
+};
+
 template<typename T>
 void SearchSpacePruning<T>::filterResponseByDepth(vector2DMat& pdfs, const vector<Size>& fsizes, const Mat& depth, const vectorf& scales, const float X, const float fx) {
 
@@ -94,6 +108,107 @@ void SearchSpacePruning<T>::filterCandidatesByDepth(Parts& parts, vectorCandidat
 	candidates = new_candidates;
 }
 
+/*! @brief suppress non-maximal root scores before backtracking
+ *
+ * Most root locations above the threshold are near-duplicates of a neighbouring
+ * maxima, and would otherwise be backtracked only to be discarded by
+ * Candidate::nonMaximaSuppression(). This keeps only the root locations which are
+ * local maxima within a window at their scale (see nonMaximaSuppression() in nms.hpp),
+ * then keeps the best topk of those across all scales and components. All other
+ * root scores are set to the lowest score (see Math::lowest()), so argmin() only backtracks the survivors
+ *
+ * @param rootv the root scores, across scale and component. These may be of type T,
+ * or fixed point (CV_32S) scores from DynamicProgram<int>
+ * @param thresh the detection threshold, in the units of rootv
+ * @param window the local maxima window size, in root cells. 0 disables local suppression
+ * @param topk the maximum number of root locations to keep. 0 keeps all of them
+ */
+template<typename T>
+void SearchSpacePruning<T>::nonMaxSuppression(vector2DMat& rootv, const double thresh, const int window, const size_t topk) const {
+	SuppressionBuffers buffers;
+	nonMaxSuppression(rootv, thresh, window, topk, buffers);
+}
+
+/*! @brief suppress non-maximal root scores before backtracking, reusing the working buffers
+ *
+ * As nonMaxSuppression() above. The masks are kept in buffers, and are only
+ * allocated if the size of a scale has changed since the last call
+ *
+ * @param rootv the root scores, across scale and component
+ * @param thresh the detection threshold, in the units of rootv
+ * @param window the local maxima window size, in root cells. 0 disables local suppression
+ * @param topk the maximum number of root locations to keep. 0 keeps all of them
+ * @param buffers the working buffers, kept between calls
+ */
+template<typename T>
+void SearchSpacePruning<T>::nonMaxSuppression(vector2DMat& rootv, const double thresh, const int window, const size_t topk, SuppressionBuffers& buffers) const {
+
+	TRACE_SPAN("nms");
+	const size_t N = rootv.size();
+	const size_t C = (N > 0) ? rootv[0].size() : 0;
+	vector2DMat& over = buffers.over;
+	vector2DMat& maxima = buffers.maxima;
+	vector2DMat& neighbours = buffers.neighbours;
+	over.resize(N);
+	maxima.resize(N);
+	neighbours.resize(N);
+	for (size_t n = 0; n < N; ++n) {
+		over[n].resize(C);
+		maxima[n].resize(C);
+		neighbours[n].resize(C);
+	}
+
+	// find the local maxima at each scale and component
+#ifdef _OPENMP
+	#pragma omp parallel for
+#endif
+	for (size_t nc = 0; nc < N*C; ++nc) {
+		const size_t n = nc / C;
+		const size_t c = nc % C;
+		if (rootv[n][c].empty()) continue;
+		compare(rootv[n][c], thresh, over[n][c], CMP_GT);
+		if (window > 0) {
+			nonMaximaSuppression(rootv[n][c], window, maxima[n][c], over[n][c], neighbours[n][c]);
+		} else {
+			over[n][c].copyTo(maxima[n][c]);
+		}
+	}
+
+	// keep a min-heap of the best topk maxima across all scales and components
+	if (topk > 0) {
+		priority_queue<RootLocation<T>, vector<RootLocation<T> >, greater<RootLocation<T> > > best;
+		for (size_t n = 0; n < N; ++n) {
+			for (size_t c = 0; c < C; ++c) {
+				if (rootv[n][c].empty()) continue;
+				vectorPoint inds;
+				Math::find(maxima[n][c], inds);
+				for (size_t i = 0; i < inds.size(); ++i) {
+					const Mat& scores = rootv[n][c];
+					const T score = scores.depth() == CV_32S ? scores.at<int>(inds[i]) : scores.at<T>(inds[i]);
+					if (best.size() == topk && !(score > best.top().score)) continue;
+					best.push(RootLocation<T>(score, n, c, inds[i]));
+					if (best.size() > topk) best.pop();
+				}
+				maxima[n][c].setTo(0);
+			}
+		}
+		for (; !best.empty(); best.pop()) {
+			const RootLocation<T>& root = best.top();
+			maxima[root.n][root.c].template at<uint8_t>(root.location) = 255;
+		}
+	}
+
+	// suppress everything else
+	for (size_t n = 0; n < N; ++n) {
+		for (size_t c = 0; c < C; ++c) {
+			if (rootv[n][c].empty()) continue;
+			const double lowest = rootv[n][c].depth() == CV_32S ? Math::lowest<int>() : Math::lowest<T>();
+			compare(maxima[n][c], 0, over[n][c], CMP_EQ);
+			rootv[n][c].setTo(lowest, over[n][c]);
+		}
+	}
+}
+
 // declare all specializations of the template (this must be the last declaration in the file)
 template class SearchSpacePruning<float>;
 template class SearchSpacePruning<double>;
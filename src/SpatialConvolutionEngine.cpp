@@ -41,11 +41,13 @@
 #endif
 #include <cassert>
 #include "SpatialConvolutionEngine.hpp"
+#include "DetectionStats.hpp"
+#include "Trace.hpp"
 using namespace std;
 using namespace cv;
 
 SpatialConvolutionEngine::SpatialConvolutionEngine(int type, size_t flen) :
-	type_(type), flen_(flen) {}
+	type_(type), flen_(flen), filters_(new vector2DMat) {}
 
 SpatialConvolutionEngine::~SpatialConvolutionEngine() {
 	// TODO Auto-generated destructor stub
@@ -62,28 +64,25 @@ SpatialConvolutionEngine::~SpatialConvolutionEngine() {
  *
  * The function supports multithreading via OpenMP
  *
- * @param feature the feature matrix
+ * @param featurev the feature matrix, split into one plane per SVM weight
  * @param filter the filter (SVM)
  * @param pdf the response to return
- * @param stride the SVM weight length
+ * @param pdfc working storage for the response of a single plane
  */
-void SpatialConvolutionEngine::convolve(const Mat& feature, vectorFilterEngine& filter, Mat& pdf, const size_t stride) {
+void SpatialConvolutionEngine::convolve(const vectorMat& featurev, vectorFilterEngine& filter, Mat& pdf, Mat& pdfc) const {
 
 	// error checking
-	assert(feature.depth() == type_);
-
-	// split the feature into separate channels
-	vectorMat featurev;
-	split(feature.reshape(stride), featurev);
+	assert(featurev.size() == flen_ && featurev[0].depth() == type_);
 
 	// calculate the output
 	Rect roi(0,0,-1,-1); // full image
 	Point offset(0,0);
 	Size fsize = featurev[0].size();
-	pdf = Mat::zeros(fsize, type_);
+	pdf.create(fsize, type_);
+	pdf.setTo(Scalar::all(0));
+	pdfc.create(fsize, type_);
 
-	for (size_t c = 0; c < stride; ++c) {
-		Mat pdfc(fsize, type_);
+	for (size_t c = 0; c < flen_; ++c) {
 #if CV_MAJOR_VERSION == 2
 		filter[c]->apply(featurev[c], pdfc, roi, offset, true);
 #else
@@ -102,25 +101,67 @@ void SpatialConvolutionEngine::convolve(const Mat& feature, vectorFilterEngine&
  * (pdf) of part location
  * @param features the input features (at different scales, and by extension, size)
  * @param responses the vector of responses (pdfs) to return
+ * @param workspace the filter engines, the planes of the features at each scale,
+ * and a plane per thread at each scale for the response of a single feature plane
+ * @param deadline the deadline after which no more filters are applied
  */
-void SpatialConvolutionEngine::pdf(const vectorMat& features, vector2DMat& responses) {
+void SpatialConvolutionEngine::pdf(const vectorMat& features, vector2DMat& responses, IConvolutionEngine::Workspace& workspace, const Deadline& deadline) const {
+
+	Workspace& ws = dynamic_cast<Workspace&>(workspace);
+	if (ws.source != filters_) createFilterEngines(ws);
 
 	// preallocate the output
 	const size_t M = features.size();
-	const size_t N = filters_.size();
+	const size_t N = filters_->size();
 	responses.resize(M, vectorMat(N));
+#ifdef _OPENMP
+	const size_t nthreads = omp_get_max_threads();
+#else
+	const size_t nthreads = 1;
+#endif
 
-	// iterate
+	// split each feature into separate channels once, for all of the filters
+	ws.planes.resize(M);
+	ws.partial.resize(M);
+#ifdef _OPENMP
+	#pragma omp parallel for
+#endif
+	for (size_t m = 0; m < M; ++m) {
+		if (features[m].empty()) continue;
+		TRACE_SPAN("split", m);
+		split(features[m].reshape(flen_), ws.planes[m]);
+		ws.partial[m].resize(nthreads);
+	}
+
+	// iterate, timing each level on each thread
+	std::vector<int64> ticks(nthreads*M, 0);
 #ifdef _OPENMP
 	#pragma omp parallel for
 #endif
 	for (size_t n = 0; n < N; ++n) {
+#ifdef _OPENMP
+		const size_t t = omp_get_thread_num();
+#else
+		const size_t t = 0;
+#endif
 		for (size_t m = 0; m < M; ++m) {
-			Mat response;
-			convolve(features[m], filters_[n], response, flen_);
-			responses[m][n] = response;
+			if (features[m].empty() || deadline.expired()) {
+				responses[m][n] = Mat();
+				continue;
+			}
+			TRACE_SPAN("convolve", m, n);
+			const int64 start = getTickCount();
+			convolve(ws.planes[m], ws.filters[n], responses[m][n], ws.partial[m][t]);
+			ticks[t*M+m] += getTickCount() - start;
 		}
 	}
+	ws.level_seconds.assign(M, 0);
+	ws.thread_seconds.assign(nthreads, 0);
+	for (size_t t = 0; t < nthreads; ++t) {
+		for (size_t m = 0; m < M; ++m) ws.level_seconds[m] += ticks[t*M+m] / getTickFrequency();
+		for (size_t m = 0; m < M; ++m) ws.thread_seconds[t] += ticks[t*M+m] / getTickFrequency();
+	}
+	if (deadline.bounded()) discardIncomplete(responses);
 }
 
 /*! @brief set the filters
@@ -133,27 +174,55 @@ void SpatialConvolutionEngine::pdf(const vectorMat& features, vector2DMat& respo
 void SpatialConvolutionEngine::setFilters(const vectorMat& filters) {
 
 	const size_t N = filters.size();
-	filters_.clear();
-	filters_.resize(N);
+	boost::shared_ptr<vector2DMat> split_filters(new vector2DMat(N));
+
+	// split each filter into separate channels
+	for (size_t n = 0; n < N; ++n) {
+		split(filters[n].reshape(flen_), (*split_filters)[n]);
+	}
+	filters_ = split_filters;
+}
+
+/*! @brief create an empty workspace
+ *
+ * The filter engines are created on the first call to pdf() with the workspace
+ */
+IConvolutionEngine::Workspace* SpatialConvolutionEngine::createWorkspace(void) const {
+	return new Workspace;
+}
 
-	// split each filter into separate channels, and create a filter engine
+/*! @brief the bytes held by the split features and partial responses
+ *
+ * The internal buffers of the filter engines are not counted
+ */
+size_t SpatialConvolutionEngine::Workspace::bytes(void) const {
+	return DetectionStats::Memory::size(planes) + DetectionStats::Memory::size(partial);
+}
+
+/*! @brief create a filter engine for each plane of each filter
+ *
+ * @param workspace the workspace to hold the filter engines
+ */
+void SpatialConvolutionEngine::createFilterEngines(Workspace& workspace) const {
+
+	const vector2DMat& filters = *filters_;
+	const size_t N = filters.size();
 	const size_t C = flen_;
+	workspace.filters.clear();
+	workspace.filters.resize(N, vectorFilterEngine(C));
 	for (size_t n = 0; n < N; ++n) {
-		vectorMat filtervec;
-		vectorFilterEngine filter_engines(C);
-		split(filters[n].reshape(C), filtervec);
+		const vectorMat& filtervec = filters[n];
+		vectorFilterEngine& filter_engines = workspace.filters[n];
 
 		// the first N-1 filters have zero-padding
 		for (size_t m = 0; m < C-1; ++m) {
-			Ptr<FilterEngine> fe = createLinearFilter(type_, type_,
+			filter_engines[m] = createLinearFilter(type_, type_,
 					filtervec[m], Point(-1,-1), 0, BORDER_CONSTANT, -1, Scalar(0,0,0,0));
-			filter_engines[m] = fe;
 		}
 
 		// the last filter has one-padding
-		Ptr<FilterEngine> fe = createLinearFilter(type_, type_,
+		filter_engines[C-1] = createLinearFilter(type_, type_,
 				filtervec[C-1], Point(-1,-1), 0, BORDER_CONSTANT, -1, Scalar(1,1,1,1));
-		filter_engines[C-1] = fe;
-		filters_[n] = filter_engines;
 	}
+	workspace.source = filters_;
 }
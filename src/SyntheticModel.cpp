@@ -0,0 +1,202 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    SyntheticModel.cpp
+ *  Created: Oct 19, 2026
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <boost/filesystem.hpp>
+#include "SyntheticModel.hpp"
+#ifdef WITH_MATLABIO
+	#include "MatlabIOModel.hpp"
+#endif
+
+/*! @brief the shape of a face model
+ *
+ * 13 viewpoint components of 68 landmarks, each with a single mixture
+ * and 5x5 cell filters on 4 pixel cells
+ */
+SyntheticModel::Parameters SyntheticModel::face(void) {
+	Parameters params;
+	params.name = "synthetic_face";
+	params.ncomponents = 13;
+	params.nparts = 68;
+	params.nmixtures = 1;
+	return params;
+}
+
+/*! @brief the shape of a person model
+ *
+ * a single component of 26 parts, each with 6 mixtures
+ * and 5x5 cell filters on 4 pixel cells
+ */
+SyntheticModel::Parameters SyntheticModel::person(void) {
+	Parameters params;
+	params.name = "synthetic_person";
+	params.ncomponents = 1;
+	params.nparts = 26;
+	params.nmixtures = 6;
+	return params;
+}
+
+bool SyntheticModel::parseTree(const std::string& name, Tree& tree) {
+	if (name == "star")   { tree = STAR;   return true; }
+	if (name == "chain")  { tree = CHAIN;  return true; }
+	if (name == "binary") { tree = BINARY; return true; }
+	if (name == "random") { tree = RANDOM; return true; }
+	return false;
+}
+
+/*! @brief generate a model of the given shape
+ *
+ * The layout of the parameters mirrors a model transferred from Matlab:
+ * each part has one filter, deformation and anchor per mixture, and one
+ * block of biases per mixture, indexed by the mixture of its parent. Parts
+ * are ordered so that every parent precedes its children, and the root has
+ * no deformation. Every weight is drawn from the seeded generator, so the
+ * same parameters always produce the same model
+ *
+ * @param params the shape of the model
+ */
+void SyntheticModel::generate(const Parameters& params) {
+
+	cv::RNG rng(params.seed);
+	const int C = std::max(params.ncomponents, 1);
+	const int P = std::max(params.nparts, 1);
+	const int K = std::max(params.nmixtures, 1);
+
+	// the primitives
+	name_      = params.name;
+	nscales_   = params.interval;
+	thresh_    = params.thresh;
+	binsize_   = params.binsize;
+	norient_   = params.norient;
+	flen_      = params.flen;
+	nparts_    = P;
+	nmixtures_ = K;
+
+	filtersw_.clear();
+	filtersi_.clear();
+	defw_.clear();
+	defi_.clear();
+	biasw_.clear();
+	biasi_.clear();
+	anchors_.clear();
+	conn_.clear();
+	biasid_.assign(C, vector2Di(P));
+	filterid_.assign(C, vector2Di(P));
+	defid_.assign(C, vector2Di(P));
+	parentid_.assign(C, vectori(P));
+
+	for (int c = 0; c < C; ++c) {
+		for (int p = 0; p < P; ++p) {
+
+			// the topology. Every parent precedes its children
+			int parent = -1;
+			if (p > 0) {
+				switch (params.tree) {
+					case STAR:   parent = 0; break;
+					case CHAIN:  parent = p-1; break;
+					case BINARY: parent = (p-1)/2; break;
+					case RANDOM: parent = rng.uniform(0, p); break;
+				}
+			}
+			parentid_[c][p] = parent;
+			if (c == 0) conn_.push_back(parent);
+
+			const cv::Size size = p == 0 ? params.rootsize : params.partsize;
+			const double sigma = 1.0 / sqrt((double)size.area() * params.flen);
+			for (int m = 0; m < K; ++m) {
+
+				// the filter, flattened to rows x (cols*flen) as from Matlab
+				cv::Mat filter(size.height, size.width * params.flen, cv::DataType<double>::type);
+				rng.fill(filter, cv::RNG::NORMAL, cv::Scalar::all(0), cv::Scalar::all(sigma));
+				filterid_[c][p].push_back(filtersw_.size());
+				filtersi_.push_back(filtersw_.size());
+				filtersw_.push_back(filter);
+
+				// the deformation: a penalty on the quadratic displacement from the anchor
+				vectorf w(4, 0.0f);
+				cv::Point anchor(0, 0);
+				if (p > 0) {
+					w[0] = rng.uniform(0.005f, 0.05f);
+					w[1] = rng.uniform(-0.01f, 0.01f);
+					w[2] = rng.uniform(0.005f, 0.05f);
+					w[3] = rng.uniform(-0.01f, 0.01f);
+					anchor = cv::Point(rng.uniform(-params.partsize.width, params.partsize.width+1),
+									   rng.uniform(-params.partsize.height, params.partsize.height+1));
+				}
+				defid_[c][p].push_back(defw_.size());
+				defi_.push_back(defw_.size());
+				defw_.push_back(w);
+				anchors_.push_back(anchor);
+
+				// the biases of this mixture given each mixture of the parent
+				biasid_[c][p].push_back(biasw_.size());
+				for (int k = 0; k < K; ++k) {
+					biasi_.push_back(biasw_.size());
+					biasw_.push_back(rng.gaussian(0.1));
+				}
+			}
+		}
+	}
+}
+
+Model* loadModel(const std::string& source) {
+
+	// determine the type of model to read, or generate one
+	if (source == "synthetic:face") return new SyntheticModel(SyntheticModel::face());
+	if (source == "synthetic:person") return new SyntheticModel(SyntheticModel::person());
+	Model* model = NULL;
+	std::string ext = boost::filesystem::path(source).extension().string();
+	if (ext.compare(".xml") == 0 || ext.compare(".yaml") == 0) {
+		model = new FileStorageModel;
+	}
+#ifdef WITH_MATLABIO
+	else if (ext.compare(".mat") == 0) {
+		model = new MatlabIOModel;
+	}
+#endif
+	else {
+		printf("Unsupported model format: %s\n", source.c_str());
+		return NULL;
+	}
+	if (!model->deserialize(source)) {
+		printf("Error deserializing file: %s\n", source.c_str());
+		delete model;
+		return NULL;
+	}
+	return model;
+}
@@ -0,0 +1,172 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    Trace.cpp
+ *  Created: Oct 19, 2026
+ */
+
+#include "Trace.hpp"
+#ifdef WITH_TRACE
+#include <fstream>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+using namespace std;
+
+namespace {
+	//! the ring buffer of spans recorded by one thread
+	struct Buffer {
+		Buffer(size_t capacity, int tid) : events(capacity), head(0), tid(tid) {}
+		std::vector<Trace::Event> events;
+		//! the number of spans ever recorded. Only the owning thread writes it
+		boost::atomic<size_t> head;
+		int tid;
+	};
+
+	//! the buffers of every thread which has recorded a span. The buffers
+	//! outlive their threads, so that their spans can still be written
+	std::vector<boost::shared_ptr<Buffer> > buffers;
+	boost::mutex buffers_mutex;
+	size_t buffer_capacity = 65536;
+
+	//! the buffer of the calling thread, owned by buffers
+	void noCleanup(Buffer*) {}
+	boost::thread_specific_ptr<Buffer> local(noCleanup);
+
+	Buffer* localBuffer(void) {
+		Buffer* buffer = local.get();
+		if (!buffer) {
+			boost::mutex::scoped_lock lock(buffers_mutex);
+			buffers.push_back(boost::shared_ptr<Buffer>(new Buffer(buffer_capacity, buffers.size())));
+			buffer = buffers.back().get();
+			local.reset(buffer);
+		}
+		return buffer;
+	}
+}
+
+boost::atomic<bool> Trace::enabled_(false);
+
+/*! @brief start or stop recording spans
+ *
+ * @param enable true to record spans
+ * @param capacity the number of spans each thread keeps, applied to threads
+ * which record their first span after this call
+ */
+void Trace::enable(bool enable, size_t capacity) {
+	{
+		boost::mutex::scoped_lock lock(buffers_mutex);
+		buffer_capacity = std::max(capacity, (size_t)1);
+	}
+	enabled_ = enable;
+}
+
+/*! @brief discard the recorded spans
+ */
+void Trace::clear(void) {
+	boost::mutex::scoped_lock lock(buffers_mutex);
+	for (size_t n = 0; n < buffers.size(); ++n) buffers[n]->head = 0;
+}
+
+/*! @brief record a completed span into the buffer of the calling thread
+ */
+void Trace::record(const char* name, int64 begin, int64 end, int level, int index) {
+	Buffer* buffer = localBuffer();
+	const size_t head = buffer->head.load(boost::memory_order_relaxed);
+	Event& event = buffer->events[head % buffer->events.size()];
+	event.name = name;
+	event.begin = begin;
+	event.end = end;
+	event.level = level;
+	event.index = index;
+	buffer->head.store(head+1, boost::memory_order_release);
+}
+
+/*! @brief write the recorded spans as Chrome trace event JSON
+ *
+ * Each thread is a track of process 1. Times are in microseconds from the
+ * first recorded span
+ *
+ * @param out the stream to write to
+ */
+void Trace::write(std::ostream& out) {
+
+	boost::mutex::scoped_lock lock(buffers_mutex);
+
+	// the earliest span still in the buffers
+	int64 origin = 0;
+	for (size_t n = 0; n < buffers.size(); ++n) {
+		const Buffer& buffer = *buffers[n];
+		const size_t head = buffer.head.load(boost::memory_order_acquire);
+		const size_t size = std::min(head, buffer.events.size());
+		for (size_t i = head - size; i < head; ++i) {
+			const int64 begin = buffer.events[i % buffer.events.size()].begin;
+			if (origin == 0 || begin < origin) origin = begin;
+		}
+	}
+
+	const double us = 1e6 / cv::getTickFrequency();
+	out << "{\"traceEvents\":[";
+	bool first = true;
+	for (size_t n = 0; n < buffers.size(); ++n) {
+		const Buffer& buffer = *buffers[n];
+		out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer.tid
+			<< ",\"args\":{\"name\":\"thread " << buffer.tid << "\"}}";
+		first = false;
+
+		const size_t head = buffer.head.load(boost::memory_order_acquire);
+		const size_t size = std::min(head, buffer.events.size());
+		for (size_t i = head - size; i < head; ++i) {
+			const Event& event = buffer.events[i % buffer.events.size()];
+			out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer.tid
+				<< ",\"ts\":" << (event.begin - origin) * us << ",\"dur\":" << (event.end - event.begin) * us
+				<< ",\"args\":{\"level\":" << event.level << ",\"index\":" << event.index << "}}";
+		}
+	}
+	out << "\n]}\n";
+}
+
+/*! @brief write the recorded spans as Chrome trace event JSON
+ *
+ * @param filename the file to write to
+ * @return false if the file could not be written
+ */
+bool Trace::write(const std::string& filename) {
+	std::ofstream out(filename.c_str());
+	if (!out) return false;
+	write(out);
+	return out.good();
+}
+
+#endif
@@ -0,0 +1,292 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    VideoDetector.cpp
+ *  Created: Oct 19, 2026
+ */
+
+#include <boost/bind/bind.hpp>
+#include "VideoDetector.hpp"
+using namespace cv;
+using namespace std;
+
+/*! @brief start the stages of the pipeline
+ *
+ * @param detector the detector to run, which must outlive the VideoDetector
+ * @param depth the maximum number of frames in flight. 1 runs a frame at a time
+ */
+template<typename T>
+VideoDetector<T>::VideoDetector(const PartsBasedDetector<T>& detector, size_t depth) :
+	detector_(detector), frames_(std::max(depth, (size_t)1)), running_(true),
+	completed_(0), dropped_(0), latency_(0), first_(0), last_(0) {
+
+	// the queues can hold every frame, so pushing onto them never fails
+	const size_t nframes = frames_.size();
+	for (size_t n = 0; n < nframes; ++n) free_.push_back(&frames_[n]);
+	features_.reset(new FrameQueue(nframes));
+	responses_.reset(new FrameQueue(nframes));
+	scores_.reset(new FrameQueue(nframes));
+	done_.reset(new FrameQueue(nframes));
+
+	threads_.create_thread(boost::bind(&VideoDetector<T>::pyramidStage, this));
+	threads_.create_thread(boost::bind(&VideoDetector<T>::convolutionStage, this));
+	threads_.create_thread(boost::bind(&VideoDetector<T>::programStage, this));
+	threads_.create_thread(boost::bind(&VideoDetector<T>::backtrackStage, this));
+}
+
+/*! @brief stop the stages of the pipeline
+ *
+ * The frames in flight are abandoned once their current stage is finished
+ */
+template<typename T>
+VideoDetector<T>::~VideoDetector() {
+	running_ = false;
+	threads_.join_all();
+}
+
+/*! @brief submit a frame to the pipeline
+ *
+ * @param frame the input color or grayscale image, which is copied
+ * @return false if a frame (this one, or an older one) was dropped
+ */
+template<typename T>
+bool VideoDetector<T>::push(const Mat& frame) {
+
+	boost::mutex::scoped_lock lock(mutex_);
+	const int64 now = getTickCount();
+	if (first_ == 0) first_ = now;
+
+	// take a free frame, or else replace the oldest frame which is waiting
+	bool accepted = true;
+	Frame* slot = NULL;
+	if (!free_.empty()) {
+		slot = free_.back();
+		free_.pop_back();
+	} else if (!input_.empty()) {
+		slot = input_.front();
+		input_.pop_front();
+		dropped_++;
+		accepted = false;
+	} else {
+		dropped_++;
+		return false;
+	}
+
+	frame.copyTo(slot->image);
+	slot->detections.clear();
+	slot->submitted = now;
+	input_.push_back(slot);
+	return accepted;
+}
+
+/*! @brief retrieve the detections of the next finished frame
+ *
+ * @param detections the output detections of the frame, replaced
+ * @return false if no frame has been finished
+ */
+template<typename T>
+bool VideoDetector<T>::pop(Detections& detections) {
+
+	Frame* frame = finished();
+	if (!frame) return false;
+	detections = frame->detections;
+	boost::mutex::scoped_lock lock(mutex_);
+	free_.push_back(frame);
+	return true;
+}
+
+/*! @brief retrieve the detections of the next finished frame, and the frame
+ *
+ * @param detections the output detections of the frame, replaced
+ * @param frame the output image the detections were found in
+ * @return false if no frame has been finished
+ */
+template<typename T>
+bool VideoDetector<T>::pop(Detections& detections, Mat& frame) {
+
+	Frame* slot = finished();
+	if (!slot) return false;
+	detections = slot->detections;
+	slot->image.copyTo(frame);
+	boost::mutex::scoped_lock lock(mutex_);
+	free_.push_back(slot);
+	return true;
+}
+
+/*! @brief retrieve the detection candidates of the next finished frame
+ *
+ * @param candidates the output candidates of the frame, replaced
+ * @return false if no frame has been finished
+ */
+template<typename T>
+bool VideoDetector<T>::pop(vectorCandidate& candidates) {
+
+	Frame* frame = finished();
+	if (!frame) return false;
+	candidates.clear();
+	frame->detections.toCandidates(candidates);
+	boost::mutex::scoped_lock lock(mutex_);
+	free_.push_back(frame);
+	return true;
+}
+
+/*! @brief the next finished frame, or NULL if there is none
+ */
+template<typename T>
+typename VideoDetector<T>::Frame* VideoDetector<T>::finished(void) {
+	Frame* frame = NULL;
+	return done_->pop(frame) ? frame : NULL;
+}
+
+/*! @brief wait for the next frame from a queue
+ *
+ * The stage spins briefly, then sleeps, so an idle pipeline does not occupy
+ * the cores used by the other stages
+ *
+ * @param queue the queue to take from
+ * @return the frame, or NULL once the pipeline is stopped
+ */
+template<typename T>
+typename VideoDetector<T>::Frame* VideoDetector<T>::take(FrameQueue& queue) {
+	Frame* frame = NULL;
+	for (size_t spin = 0; running_; ++spin) {
+		if (queue.pop(frame)) return frame;
+		if (spin < 64) boost::this_thread::yield();
+		else boost::this_thread::sleep(boost::posix_time::microseconds(100));
+	}
+	return NULL;
+}
+
+/*! @brief wait for the oldest pushed frame
+ *
+ * @return the frame, or NULL once the pipeline is stopped
+ */
+template<typename T>
+typename VideoDetector<T>::Frame* VideoDetector<T>::takeInput(void) {
+	for (size_t spin = 0; running_; ++spin) {
+		{
+			boost::mutex::scoped_lock lock(mutex_);
+			if (!input_.empty()) {
+				Frame* frame = input_.front();
+				input_.pop_front();
+				return frame;
+			}
+		}
+		if (spin < 64) boost::this_thread::yield();
+		else boost::this_thread::sleep(boost::posix_time::microseconds(100));
+	}
+	return NULL;
+}
+
+//! compute the feature pyramid of each frame
+template<typename T>
+void VideoDetector<T>::pyramidStage(void) {
+	while (Frame* frame = takeInput()) {
+		frame->workspace.stats.clear();
+		detector_.featurePyramid(frame->image, frame->workspace);
+		features_->push(frame);
+	}
+}
+
+//! convolve the features of each frame with the part filters
+template<typename T>
+void VideoDetector<T>::convolutionStage(void) {
+	while (Frame* frame = take(*features_)) {
+		detector_.convolve(frame->workspace);
+		responses_->push(frame);
+	}
+}
+
+//! run the dynamic program over the part responses of each frame
+template<typename T>
+void VideoDetector<T>::programStage(void) {
+	while (Frame* frame = take(*responses_)) {
+		detector_.minimize(frame->workspace);
+		scores_->push(frame);
+	}
+}
+
+//! suppress and backtrack the root scores of each frame, and finish it
+template<typename T>
+void VideoDetector<T>::backtrackStage(void) {
+	while (Frame* frame = take(*scores_)) {
+		detector_.backtrack(frame->workspace, frame->detections);
+		{
+			boost::mutex::scoped_lock lock(mutex_);
+			last_ = getTickCount();
+			latency_ += last_ - frame->submitted;
+			completed_++;
+		}
+		done_->push(frame);
+	}
+}
+
+//! the number of frames which have been finished
+template<typename T>
+size_t VideoDetector<T>::completed(void) const {
+	boost::mutex::scoped_lock lock(mutex_);
+	return completed_;
+}
+
+//! the number of frames which have been dropped
+template<typename T>
+size_t VideoDetector<T>::dropped(void) const {
+	boost::mutex::scoped_lock lock(mutex_);
+	return dropped_;
+}
+
+/*! @brief the throughput of the pipeline
+ *
+ * @return the frames finished per second, from the first push to the last completion
+ */
+template<typename T>
+double VideoDetector<T>::throughput(void) const {
+	boost::mutex::scoped_lock lock(mutex_);
+	if (completed_ == 0 || last_ <= first_) return 0;
+	return completed_ * getTickFrequency() / (double)(last_ - first_);
+}
+
+/*! @brief the mean end-to-end latency of the pipeline
+ *
+ * @return the mean time from push() to the completion of a frame, in seconds
+ */
+template<typename T>
+double VideoDetector<T>::latency(void) const {
+	boost::mutex::scoped_lock lock(mutex_);
+	if (completed_ == 0) return 0;
+	return latency_ / getTickFrequency() / (double)completed_;
+}
+
+// declare all specializations of the template
+template class VideoDetector<float>;
+template class VideoDetector<double>;
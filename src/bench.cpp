@@ -0,0 +1,529 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    bench.cpp
+ *  Created: Oct 19, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#if CV_MAJOR_VERSION >= 3
+#include <opencv2/imgcodecs.hpp>
+#else
+#include <opencv2/highgui/highgui.hpp>
+#endif
+#include "PartsBasedDetector.hpp"
+#include "SyntheticModel.hpp"
+#include "types.hpp"
+using namespace cv;
+using namespace std;
+
+/*! @brief the options of a benchmark run */
+struct Options {
+	Options() : warmup(2), iterations(10), seed(0), workspace(false), scaling(false), output(NULL) {}
+	vectorMat images;
+	vector<string> names;
+	vector<Size> sizes;
+	vectori threads;
+	vector<string> precisions;
+	int warmup;
+	int iterations;
+	int seed;
+	bool workspace;
+	bool scaling;
+	FILE* output;
+};
+
+/*! @brief the mean stage statistics of a run, per call */
+struct Sample {
+	Sample() : threads(1) {
+		for (int s = 0; s < DetectionStats::NSTAGES; ++s) wall[s] = cpu[s] = 0;
+	}
+	int threads;
+	double wall[DetectionStats::NSTAGES];
+	double cpu[DetectionStats::NSTAGES];
+	vector<double> busy[DetectionStats::NSTAGES];
+};
+
+/*! @brief the p-th percentile of a sorted vector, by nearest rank */
+static double percentile(const vector<double>& sorted, double p) {
+	if (sorted.empty()) return 0;
+	const size_t rank = (size_t)ceil(p / 100.0 * sorted.size());
+	return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+}
+
+/*! @brief reset the peak resident set size to the current one
+ *
+ * Writing 5 to /proc/self/clear_refs resets VmHWM on Linux, so that
+ * peakRss() reports the peak of a single run rather than of the process
+ *
+ * @return true if the peak was reset
+ */
+static bool resetPeakRss(void) {
+	FILE* refs = fopen("/proc/self/clear_refs", "w");
+	if (!refs) return false;
+	const bool reset = fputs("5", refs) >= 0;
+	return fclose(refs) == 0 && reset;
+}
+
+/*! @brief the peak resident set size, in bytes
+ *
+ * VmHWM from /proc/self/status, which follows resetPeakRss(). Where that is
+ * not available, the process-lifetime high-water mark from getrusage()
+ */
+static long peakRss(void) {
+	FILE* status = fopen("/proc/self/status", "r");
+	if (status) {
+		char line[256];
+		long kb = -1;
+		while (kb < 0 && fgets(line, sizeof(line), status)) {
+			if (sscanf(line, "VmHWM: %ld kB", &kb) != 1) kb = -1;
+		}
+		fclose(status);
+		if (kb >= 0) return kb * 1024L;
+	}
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss * 1024L;
+}
+
+/*! @brief the largest of each memory account over the calls of a run */
+static void largest(DetectionStats::Memory& into, const DetectionStats::Memory& from) {
+	into.current = std::max(into.current, from.current);
+	into.peak = std::max(into.peak, from.peak);
+	for (int s = 0; s < DetectionStats::NSTAGES; ++s) {
+		into.stage_current[s] = std::max(into.stage_current[s], from.stage_current[s]);
+		into.stage_peak[s] = std::max(into.stage_peak[s], from.stage_peak[s]);
+	}
+	if (into.level_peak.size() < from.level_peak.size()) into.level_peak.resize(from.level_peak.size(), 0);
+	for (size_t n = 0; n < from.level_peak.size(); ++n) into.level_peak[n] = std::max(into.level_peak[n], from.level_peak[n]);
+	if (into.component_peak.size() < from.component_peak.size()) into.component_peak.resize(from.component_peak.size(), 0);
+	for (size_t c = 0; c < from.component_peak.size(); ++c) into.component_peak[c] = std::max(into.component_peak[c], from.component_peak[c]);
+}
+
+/*! @brief write a list of byte counts */
+static void writeBytes(FILE* out, const vector<size_t>& bytes) {
+	fprintf(out, "[");
+	for (size_t n = 0; n < bytes.size(); ++n) fprintf(out, "%s%ld", n ? ", " : "", bytes[n]);
+	fprintf(out, "]");
+}
+
+/*! @brief the workload: every image at every size */
+static void workload(const Options& options, vectorMat& images, vector<string>& names) {
+	images.clear();
+	names.clear();
+	for (size_t i = 0; i < options.images.size(); ++i) {
+		if (options.sizes.empty()) {
+			images.push_back(options.images[i]);
+			names.push_back(options.names[i]);
+		}
+		for (size_t s = 0; s < options.sizes.size(); ++s) {
+			Mat resized;
+			resize(options.images[i], resized, options.sizes[s]);
+			images.push_back(resized);
+			names.push_back(format("%s@%dx%d", options.names[i].c_str(), options.sizes[s].width, options.sizes[s].height));
+		}
+	}
+}
+
+/*! @brief restore the filters of a model as they were loaded
+ *
+ * distributeModel() converts the filters of the model to the precision of the
+ * detector in place, so without this a double run which follows a float one
+ * would detect with float-rounded weights
+ *
+ * @param model the model to restore
+ * @param filters the filters of the model as they were loaded
+ */
+static void restore(Model& model, const vectorMat& filters) {
+	model.filters().resize(filters.size());
+	for (size_t n = 0; n < filters.size(); ++n) filters[n].copyTo(model.filters()[n]);
+}
+
+/*! @brief time detect() over the workload at one precision and thread count, and write the results */
+template<typename T>
+static void run(Model& model, const Options& options, const char* precision, int threads, bool& first, Sample& sample) {
+
+	PartsBasedDetector<T> pbd;
+	pbd.distributeModel(model);
+#ifdef _OPENMP
+	omp_set_num_threads(threads);
+#endif
+
+	vectorMat images;
+	vector<string> names;
+	workload(options, images, names);
+
+	// warm up the caches, the thread pool and the convolution workspaces
+	DetectionWorkspace workspace;
+	Detections detections;
+	DetectionStats stats;
+	for (int w = 0; w < options.warmup; ++w) {
+		for (size_t i = 0; i < images.size(); ++i) {
+			detections.clear();
+			if (options.workspace) pbd.detect(images[i], workspace, detections);
+			else pbd.detect(images[i], detections, stats);
+		}
+	}
+
+	// time each call
+	vector<double> latency;
+	DetectionStats::Memory memory;
+	sample = Sample();
+	sample.threads = threads;
+	size_t candidates = 0, roots = 0, pruned = 0;
+	const bool per_run = resetPeakRss();
+	const int64 start = getTickCount();
+	for (int n = 0; n < options.iterations; ++n) {
+		for (size_t i = 0; i < images.size(); ++i) {
+			detections.clear();
+			const int64 ticks = getTickCount();
+			if (options.workspace) {
+				pbd.detect(images[i], workspace, detections);
+				stats = workspace.stats;
+			} else {
+				pbd.detect(images[i], detections, stats);
+			}
+			latency.push_back((getTickCount() - ticks) / getTickFrequency());
+			for (int s = 0; s < DetectionStats::NSTAGES; ++s) {
+				sample.wall[s] += stats.wall[s];
+				sample.cpu[s] += stats.cpu[s];
+				vector<double>& busy = sample.busy[s];
+				if (busy.size() < stats.thread_busy[s].size()) busy.resize(stats.thread_busy[s].size(), 0);
+				for (size_t t = 0; t < stats.thread_busy[s].size(); ++t) busy[t] += stats.thread_busy[s][t];
+			}
+			largest(memory, stats.memory);
+			candidates += detections.size();
+			roots += stats.roots;
+			pruned += stats.roots_pruned;
+		}
+	}
+	const double elapsed = (getTickCount() - start) / getTickFrequency();
+
+	vector<double> sorted(latency);
+	std::sort(sorted.begin(), sorted.end());
+	double mean = 0;
+	for (size_t n = 0; n < latency.size(); ++n) mean += latency[n];
+	const size_t ncalls = std::max(latency.size(), (size_t)1);
+	mean /= ncalls;
+	for (int s = 0; s < DetectionStats::NSTAGES; ++s) {
+		sample.wall[s] /= ncalls;
+		sample.cpu[s] /= ncalls;
+		for (size_t t = 0; t < sample.busy[s].size(); ++t) sample.busy[s][t] /= ncalls;
+	}
+
+	FILE* out = options.output;
+	fprintf(out, "%s\n    {\"precision\": \"%s\", \"threads\": %d, \"images\": %ld, \"iterations\": %d, \"workspace\": %s,\n",
+			first ? "" : ",", precision, threads, images.size(), options.iterations, options.workspace ? "true" : "false");
+	fprintf(out, "     \"latency\": {\"mean\": %.6f, \"median\": %.6f, \"p95\": %.6f, \"p99\": %.6f, \"min\": %.6f, \"max\": %.6f},\n",
+			mean, percentile(sorted, 50), percentile(sorted, 95), percentile(sorted, 99),
+			sorted.empty() ? 0 : sorted.front(), sorted.empty() ? 0 : sorted.back());
+	fprintf(out, "     \"throughput\": %.3f, \"candidates\": %.2f, \"pruned\": %.4f,\n",
+			elapsed > 0 ? latency.size() / elapsed : 0, (double)candidates / ncalls, roots ? (double)pruned / roots : 0);
+	fprintf(out, "     \"peak_rss\": {\"bytes\": %ld, \"scope\": \"%s\"},\n", peakRss(), per_run ? "run" : "process");
+	fprintf(out, "     \"stages\": {");
+	for (int s = 0; s < DetectionStats::NSTAGES; ++s) {
+		fprintf(out, "%s\"%s\": %.6f", s ? ", " : "", DetectionStats::name((DetectionStats::Stage)s), sample.wall[s]);
+	}
+	fprintf(out, "},\n     \"memory\": {\"peak\": %ld, \"held\": %ld, \"stages\": {", memory.peak, memory.current);
+	for (int s = 0; s < DetectionStats::NSTAGES; ++s) {
+		fprintf(out, "%s\"%s\": {\"peak\": %ld, \"held\": %ld}", s ? ", " : "", DetectionStats::name((DetectionStats::Stage)s),
+				memory.stage_peak[s], memory.stage_current[s]);
+	}
+	fprintf(out, "},\n                \"levels\": ");
+	writeBytes(out, memory.level_peak);
+	fprintf(out, ", \"components\": ");
+	writeBytes(out, memory.component_peak);
+	fprintf(out, "}}");
+	fflush(out);
+	first = false;
+}
+
+/*! @brief the parallel efficiency of a stage at one thread count, relative to one thread
+ *
+ * The thread-seconds p*Tp of a stage on p threads either do the serial work T1,
+ * are inflated (CPU time beyond the serial CPU time, such as synchronization and
+ * contention for memory), or are idle (p*Tp less the CPU time). Where the stage
+ * records the time each thread spent in its parallel loops, the idle time is
+ * split into load imbalance (threads waiting for the busiest thread within the
+ * loops) and serial sections (every thread but one waiting outside the loops)
+ */
+struct Efficiency {
+	double speedup;
+	double efficiency;
+	double karp_flatt;
+	double inflation;
+	double idle;
+	double imbalance;
+	double serial;
+	bool attributed;
+};
+
+static Efficiency efficiency(double wall1, double cpu1, double wall, double cpu, const vector<double>& busy, int threads) {
+	Efficiency e;
+	const double p = threads;
+	const double capacity = std::max(p * wall, 1e-12);
+	e.speedup = wall > 0 ? wall1 / wall : 0;
+	e.efficiency = e.speedup / p;
+	e.karp_flatt = threads > 1 && e.speedup > 0 ? (1/e.speedup - 1/p) / (1 - 1/p) : 0;
+	e.inflation = (cpu - cpu1) / capacity;
+	e.idle = std::max(capacity - cpu, 0.0) / capacity;
+	e.attributed = !busy.empty();
+	e.imbalance = e.serial = 0;
+	if (e.attributed) {
+		const double span = *std::max_element(busy.begin(), busy.end());
+		double waiting = 0;
+		for (size_t t = 0; t < busy.size(); ++t) waiting += span - busy[t];
+		e.imbalance = waiting / capacity;
+		e.serial = (p - 1) * std::max(wall - span, 0.0) / capacity;
+	}
+	return e;
+}
+
+/*! @brief report the speedup and parallel efficiency of each stage over a thread sweep
+ *
+ * The samples are of one precision, and the first is the single threaded reference.
+ * A table is printed to the console, and the same figures are appended to the JSON
+ */
+static void scaling(const vector<Sample>& samples, const char* precision, FILE* out, bool& first) {
+
+	if (samples.empty() || samples[0].threads != 1) return;
+	const Sample& reference = samples[0];
+	const char* policy = getenv("OMP_WAIT_POLICY");
+	fprintf(stderr, "\nthread scaling (%s)%s\n", precision, policy && string(policy) == "passive" ? "" :
+			", run with OMP_WAIT_POLICY=passive so that waiting threads are not counted as busy");
+	fprintf(stderr, "%-12s %7s %10s %8s %10s %10s %9s %9s %9s %9s\n", "stage", "threads", "wall ms", "speedup",
+			"efficiency", "karp-flatt", "inflation", "idle", "imbalance", "serial");
+	for (int s = 0; s <= DetectionStats::NSTAGES; ++s) {
+		const bool total = s == DetectionStats::NSTAGES;
+		const char* name = total ? "total" : DetectionStats::name((DetectionStats::Stage)s);
+		for (size_t n = 0; n < samples.size(); ++n) {
+			const Sample& sample = samples[n];
+			double wall1 = 0, cpu1 = 0, wall = 0, cpu = 0;
+			vector<double> busy;
+			for (int k = total ? 0 : s; k < (total ? (int)DetectionStats::NSTAGES : s+1); ++k) {
+				wall1 += reference.wall[k];
+				cpu1 += reference.cpu[k];
+				wall += sample.wall[k];
+				cpu += sample.cpu[k];
+			}
+			if (!total) busy = sample.busy[s];
+			const Efficiency e = efficiency(wall1, cpu1, wall, cpu, busy, sample.threads);
+			fprintf(stderr, "%-12s %7d %10.3f %8.2f %9.1f%% %10.3f %8.1f%% %8.1f%%", name, sample.threads, wall * 1e3,
+					e.speedup, e.efficiency * 100, e.karp_flatt, e.inflation * 100, e.idle * 100);
+			if (e.attributed) fprintf(stderr, " %8.1f%% %8.1f%%\n", e.imbalance * 100, e.serial * 100);
+			else fprintf(stderr, " %9s %9s\n", "-", "-");
+
+			fprintf(out, "%s\n    {\"precision\": \"%s\", \"stage\": \"%s\", \"threads\": %d, \"wall\": %.6f, \"speedup\": %.4f, \"efficiency\": %.4f,\n",
+					first ? "" : ",", precision, name, sample.threads, wall, e.speedup, e.efficiency);
+			fprintf(out, "     \"karp_flatt\": %.4f, \"inflation\": %.4f, \"idle\": %.4f", e.karp_flatt, e.inflation, e.idle);
+			if (e.attributed) fprintf(out, ", \"imbalance\": %.4f, \"serial\": %.4f}", e.imbalance, e.serial);
+			else fprintf(out, ", \"imbalance\": null, \"serial\": null}");
+			first = false;
+		}
+	}
+	fflush(out);
+}
+
+/*! @brief parse a comma separated list of sizes, such as 640x480,1280x720 */
+static bool parseSizes(const string& arg, vector<Size>& sizes) {
+	vector<string> items;
+	boost::split(items, arg, boost::is_any_of(","));
+	for (size_t n = 0; n < items.size(); ++n) {
+		int width, height;
+		if (sscanf(items[n].c_str(), "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) return false;
+		sizes.push_back(Size(width, height));
+	}
+	return true;
+}
+
+static void usage(void) {
+	printf("Usage: PartsBasedDetector_bench model_file [options] [image_file ...]\n"
+		"  model_file                an .xml, .yaml (or .mat) model, or synthetic:face or\n"
+		"                            synthetic:person for a random model of that shape\n"
+		"  --sizes WxH[,WxH...]      resize each image to each size. Without images, random images\n"
+		"                            of each size are generated (default 640x480)\n"
+		"  --warmup N                untimed passes over the workload (default 2)\n"
+		"  --iterations N            timed passes over the workload (default 10)\n"
+		"  --threads N[,N...]        OpenMP thread counts to sweep (default the maximum)\n"
+		"  --scaling                 sweep 1, 2, 4, ... threads up to the number of cores, and\n"
+		"                            report the speedup and parallel efficiency of each stage\n"
+		"  --precision P[,P...]      float, double or both (default both)\n"
+		"  --seed S                  seed of the random images (default 0)\n"
+		"  --workspace               reuse a DetectionWorkspace between calls\n"
+		"  --output file.json        write the results to a file (default stdout)\n");
+}
+
+int main(int argc, char** argv) {
+
+	// check arguments
+	if (argc < 2) {
+		usage();
+		exit(-1);
+	}
+	Options options;
+	options.output = stdout;
+	vector<string> files;
+	for (int n = 2; n < argc; ++n) {
+		const string arg(argv[n]);
+		const bool value = n+1 < argc;
+		if (arg == "--sizes" && value) {
+			if (!parseSizes(argv[++n], options.sizes)) { usage(); exit(-1); }
+		} else if (arg == "--warmup" && value) {
+			options.warmup = atoi(argv[++n]);
+		} else if (arg == "--iterations" && value) {
+			options.iterations = atoi(argv[++n]);
+		} else if (arg == "--threads" && value) {
+			vector<string> items;
+			boost::split(items, argv[++n], boost::is_any_of(","));
+			for (size_t i = 0; i < items.size(); ++i) options.threads.push_back(std::max(atoi(items[i].c_str()), 1));
+		} else if (arg == "--precision" && value) {
+			boost::split(options.precisions, argv[++n], boost::is_any_of(","));
+		} else if (arg == "--seed" && value) {
+			options.seed = atoi(argv[++n]);
+		} else if (arg == "--workspace") {
+			options.workspace = true;
+		} else if (arg == "--scaling") {
+			options.scaling = true;
+		} else if (arg == "--output" && value) {
+			options.output = fopen(argv[++n], "w");
+			if (!options.output) {
+				printf("Could not open %s for writing\n", argv[n]);
+				exit(-1);
+			}
+		} else if (arg.compare(0, 2, "--") == 0) {
+			usage();
+			exit(-1);
+		} else {
+			files.push_back(arg);
+		}
+	}
+	if (options.precisions.empty() || (options.precisions.size() == 1 && options.precisions[0] == "both")) {
+		options.precisions.clear();
+		options.precisions.push_back("float");
+		options.precisions.push_back("double");
+	}
+#ifdef _OPENMP
+	const int ncores = omp_get_num_procs();
+	const int nthreads = omp_get_max_threads();
+#else
+	const int ncores = 1;
+	const int nthreads = 1;
+#endif
+	if (options.scaling) {
+		// the sweep is relative to a single thread, so it always comes first
+		if (options.threads.empty()) {
+			for (int t = 1; t < ncores; t *= 2) options.threads.push_back(t);
+			options.threads.push_back(ncores);
+		}
+		std::sort(options.threads.begin(), options.threads.end());
+		options.threads.erase(std::unique(options.threads.begin(), options.threads.end()), options.threads.end());
+		if (options.threads[0] != 1) options.threads.insert(options.threads.begin(), 1);
+	}
+	if (options.threads.empty()) options.threads.push_back(nthreads);
+
+	// determine the type of model to read, or generate one
+	const string source(argv[1]);
+	boost::scoped_ptr<Model> model(loadModel(source));
+	if (!model) exit(-2);
+
+	// load the images, or generate them reproducibly
+	for (size_t n = 0; n < files.size(); ++n) {
+		Mat im = imread(files[n]);
+		if (im.empty()) {
+			printf("Image not found or invalid image format: %s\n", files[n].c_str());
+			exit(-4);
+		}
+		options.images.push_back(im);
+		options.names.push_back(boost::filesystem::path(files[n]).filename().string());
+	}
+	if (options.images.empty()) {
+		if (options.sizes.empty()) options.sizes.push_back(Size(640, 480));
+		RNG rng(options.seed);
+		for (size_t s = 0; s < options.sizes.size(); ++s) {
+			Mat im(options.sizes[s], CV_8UC3);
+			rng.fill(im, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+			options.images.push_back(im);
+			options.names.push_back(format("random%ld", s));
+		}
+		options.sizes.clear();
+	}
+
+	// sweep the precisions and thread counts
+	FILE* out = options.output;
+	fprintf(out, "{\n  \"model\": \"%s\",\n  \"workload\": [", model->name().c_str());
+	vectorMat images;
+	vector<string> names;
+	workload(options, images, names);
+	for (size_t i = 0; i < images.size(); ++i) {
+		fprintf(out, "%s\"%s\"", i ? ", " : "", names[i].c_str());
+	}
+	fprintf(out, "],\n  \"runs\": [");
+	bool first = true;
+	vector<vector<Sample> > samples(options.precisions.size(), vector<Sample>(options.threads.size()));
+	vectorMat filters(model->filters().size());
+	for (size_t n = 0; n < filters.size(); ++n) filters[n] = model->filters()[n].clone();
+	for (size_t p = 0; p < options.precisions.size(); ++p) {
+		for (size_t t = 0; t < options.threads.size(); ++t) {
+			restore(*model, filters);
+			if (options.precisions[p] == "float") run<float>(*model, options, "float", options.threads[t], first, samples[p][t]);
+			else if (options.precisions[p] == "double") run<double>(*model, options, "double", options.threads[t], first, samples[p][t]);
+			else fprintf(stderr, "Unknown precision %s\n", options.precisions[p].c_str());
+		}
+	}
+	fprintf(out, "\n  ]");
+	if (options.scaling) {
+		fprintf(out, ",\n  \"scaling\": [");
+		first = true;
+		for (size_t p = 0; p < options.precisions.size(); ++p) {
+			if (options.precisions[p] == "float" || options.precisions[p] == "double") {
+				scaling(samples[p], options.precisions[p].c_str(), out, first);
+			}
+		}
+		fprintf(out, "\n  ]");
+	}
+	fprintf(out, "\n}\n");
+	if (out != stdout) fclose(out);
+	return 0;
+}
@@ -37,71 +37,93 @@
  */
 
 #include <stdio.h>
-#include <boost/filesystem.hpp>
 #include "PartsBasedDetector.hpp"
 #include "Candidate.hpp"
-#include "FileStorageModel.hpp"
-#ifdef WITH_MATLABIO
-	#include "MatlabIOModel.hpp"
-#endif
+#include "SyntheticModel.hpp"
 #include "Visualize.hpp"
 #include "types.hpp"
 #include "nms.hpp"
 #include "Rect3.hpp"
 #include "DistanceTransform.hpp"
+#include "Trace.hpp"
+#include "PerfCounters.hpp"
 using namespace cv;
 using namespace std;
 
 int main(int argc, char** argv) {
 
-	// check arguments
-	if (argc != 3 && argc != 4) {
-		printf("Usage: PartsBasedDetector model_file image_file [depth_file]\n");
-		exit(-1);
-	}
-
-	// determine the type of model to read
-	boost::scoped_ptr<Model> model;
-	string ext = boost::filesystem::path(argv[1]).extension().string();
-	if (ext.compare(".xml") == 0 || ext.compare(".yaml") == 0) {
-		model.reset(new FileStorageModel);
+	// check arguments, taking out the flags
+	string trace;
+	bool stats = false;
+	vector<char*> args(argv, argv+argc);
+	for (size_t n = 1; n < args.size(); ) {
+		if (string(args[n]).compare("--trace") == 0 && n+1 < args.size()) {
+			trace = args[n+1];
+			args.erase(args.begin()+n, args.begin()+n+2);
+		} else if (string(args[n]).compare("--stats") == 0) {
+			stats = true;
+			args.erase(args.begin()+n);
+		} else {
+			n++;
+		}
 	}
-#ifdef WITH_MATLABIO
-	else if (ext.compare(".mat") == 0) {
-		model.reset(new MatlabIOModel);
-	}
-#endif
-	else {
-		printf("Unsupported model format: %s\n", ext.c_str());
-		exit(-2);
+	argc = args.size();
+	argv = &args[0];
+	if (argc != 3) {
+		printf("Usage: PartsBasedDetector [--trace trace.json] [--stats] model_file image_file\n");
+		exit(-1);
 	}
-	bool ok = model->deserialize(argv[1]);
-	if (!ok) {
-		printf("Error deserializing file\n");
-		exit(-3);
+	if (stats && !PerfCounters::enable(true)) printf("Hardware performance counters are unavailable\n");
+	if (!trace.empty()) {
+		Trace::enable(true);
+		if (!Trace::enabled()) printf("Tracing is not compiled in, configure with -DWITH_TRACE=ON\n");
 	}
 
+	// determine the type of model to read, or generate one
+	boost::scoped_ptr<Model> model(loadModel(argv[1]));
+	if (!model) exit(-2);
+
 	// create the PartsBasedDetector and distribute the model parameters
 	PartsBasedDetector<float> pbd;
 	pbd.distributeModel(*model);
 
 	// load the image from file
-	Mat_<float> depth;
 	Mat im = imread(argv[2]);
         if (im.empty()) {
             printf("Image not found or invalid image format\n");
             exit(-4);
         }
-	if (argc == 4) {
-		depth = imread(argv[3], IMREAD_ANYDEPTH);
-		// convert the depth image from mm to m
-		depth = depth / 1000.0f;
-	}
 
 	// detect potential candidates in the image
 	vector<Candidate> candidates;
-	pbd.detect(im, depth, candidates);
+	Detections detections;
+	DetectionStats detection_stats;
+	pbd.detect(im, detections, detection_stats);
+	detections.toCandidates(candidates);
 	printf("Number of candidates: %ld\n", candidates.size());
+	if (stats) {
+		const DetectionStats::Memory& memory = detection_stats.memory;
+		printf("%-12s %10s %10s %12s %6s %12s %12s %10s\n", "stage", "wall (ms)", "cpu (ms)", "cycles", "ipc", "llc misses", "br misses", "peak (MB)");
+		for (int s = 0; s < DetectionStats::NSTAGES; ++s) {
+			const PerfCounts& counts = detection_stats.counters[s];
+			printf("%-12s %10.2f %10.2f %12.0f %6.2f %12.0f %12.0f %10.2f\n", DetectionStats::name((DetectionStats::Stage)s),
+					detection_stats.wall[s]*1e3, detection_stats.cpu[s]*1e3, counts.cycles, counts.ipc(), counts.llc_misses, counts.branch_misses,
+					memory.stage_peak[s] / 1048576.0);
+		}
+		std::vector<ThreadPerfCounts> threads;
+		for (int s = 0; s < DetectionStats::NSTAGES; ++s) PerfCounters::accumulate(threads, detection_stats.thread_counters[s]);
+		for (size_t t = 0; t < threads.size(); ++t) {
+			if (threads[t].counts.cycles == 0) continue;
+			printf("thread %-5ld %12.0f cycles %6.2f ipc %12.0f llc misses %12.0f br misses\n", threads[t].tid,
+					threads[t].counts.cycles, threads[t].counts.ipc(), threads[t].counts.llc_misses, threads[t].counts.branch_misses);
+		}
+		printf("levels: %ld, filters: %ld, threads: %ld, workspace: %ld bytes, peak: %ld bytes, roots pruned: %.1f%%\n", detection_stats.levels,
+				detection_stats.filters, detection_stats.threads, detection_stats.bytes, memory.peak, detection_stats.prunedFraction() * 100);
+	}
+	if (Trace::enabled()) {
+		if (Trace::write(trace)) printf("Trace written to %s\n", trace.c_str());
+		else printf("Error writing trace to %s\n", trace.c_str());
+	}
 
 	// display the best candidates
 	Visualize visualize(model->name());
@@ -0,0 +1,531 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    microbench.cpp
+ *  Created: Oct 19, 2026
+ */
+
+/*
+ * A micro-benchmark of the kernels which dominate detection: HOG features,
+ * spatial and Fourier convolution, the distance transform, the mixture
+ * reductions, find() and non-maxima suppression. Each kernel is timed in
+ * isolation on synthetic inputs across a range of sizes, and reported in
+ * ns/element, GB/s and GFLOP/s against the bandwidth and arithmetic peaks
+ * measured on the host, in the manner of a roofline model.
+ *
+ * The byte and flop counts are nominal: they count the compulsory traffic
+ * and the arithmetic of the algorithm, not of any particular implementation,
+ * so that the same kernel can be compared across revisions
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <boost/scoped_ptr.hpp>
+#include <boost/algorithm/string.hpp>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <opencv2/core/core.hpp>
+#include "HOGFeatures.hpp"
+#include "SpatialConvolutionEngine.hpp"
+#include "FourierConvolutionEngine.hpp"
+#include "DistanceTransform.hpp"
+#include "Candidate.hpp"
+#include "Math.hpp"
+#include "types.hpp"
+using namespace cv;
+using namespace std;
+
+/*! @brief the options of a micro-benchmark run */
+struct Options {
+	Options() : flen(32), filter(5), mixtures(8), seconds(0.1), seed(0), threads(1) {}
+	vector<Size> sizes;
+	vector<string> kernels;
+	vector<string> precisions;
+	int flen;
+	int filter;
+	int mixtures;
+	double seconds;
+	int seed;
+	int threads;
+};
+
+/*! @brief the peaks of the host, measured rather than quoted */
+struct Roofline {
+	double bandwidth;
+	double gflops;
+	/*! @brief the attainable GFLOP/s at a given arithmetic intensity (flops/byte) */
+	double attainable(double intensity) const { return std::min(gflops, intensity * bandwidth); }
+	/*! @brief the arithmetic intensity at which the kernel becomes compute bound */
+	double ridge(void) const { return bandwidth > 0 ? gflops / bandwidth : 0; }
+};
+
+/*! @brief a kernel under test
+ *
+ * Subclasses prepare their inputs at construction, so that run() times only
+ * the kernel itself, and report the nominal work of a single run()
+ */
+class Kernel {
+public:
+	Kernel() : elements(0), bytes(0), flops(0) {}
+	virtual ~Kernel() {}
+	virtual const char* name(void) const = 0;
+	virtual void run(void) = 0;
+	double elements;
+	double bytes;
+	double flops;
+};
+
+/*! @brief HOG features of a single image
+ *
+ * per pixel: the image is read once, the gradient takes 2 differences per channel
+ * and the orientation is binned by a dot product against norient/2 directions.
+ * The histogram, its norm and the flen channel feature are written per cell
+ */
+template<typename T>
+class HOGKernel : public Kernel {
+public:
+	HOGKernel(const Size& size, const Options& options, RNG& rng) : hog_(4, 5, options.flen, 18), im_(size, CV_8UC3) {
+		rng.fill(im_, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+		const double cells = (double)(size.width/4) * (size.height/4);
+		elements = size.area();
+		bytes = size.area() * 3.0 + cells * (18 + 1 + options.flen) * sizeof(T);
+		flops = size.area() * (3 * 5.0 + 9 * 2 + 4) + cells * options.flen * 4.0;
+	}
+	const char* name(void) const { return "hog"; }
+	void run(void) { hog_.levelFeatures(im_, feature_, scratch_); }
+private:
+	HOGFeatures<T> hog_;
+	Mat im_;
+	Mat feature_;
+	vectorMat scratch_;
+};
+
+/*! @brief the response of one feature map to one filter, via an engine's pdf()
+ *
+ * the spatial engine performs 2 flops per filter tap per channel per output, and
+ * the Fourier engine 5 N log2(N) per transform, 6 per complex multiply-add
+ */
+class ConvolutionKernel : public Kernel {
+public:
+	ConvolutionKernel(IConvolutionEngine* engine, const char* name, int type, const Size& size, const Options& options, RNG& rng) :
+		engine_(engine), name_(name), features_(1), workspace_(engine->createWorkspace()) {
+		const int C = options.flen;
+		const int F = options.filter;
+		features_[0].create(size.height, size.width*C, type);
+		rng.fill(features_[0], RNG::UNIFORM, Scalar::all(-1), Scalar::all(1));
+		vectorMat filters(1, Mat(F, F*C, type));
+		rng.fill(filters[0], RNG::UNIFORM, Scalar::all(-1), Scalar::all(1));
+		engine_->setFilters(filters);
+		const double esize = CV_ELEM_SIZE(type);
+		elements = size.area();
+		bytes = esize * (size.area() * C + F*F*C + size.area());
+		flops = 2.0 * size.area() * F*F*C;
+	}
+	const char* name(void) const { return name_; }
+	void run(void) { engine_->pdf(features_, responses_, *workspace_, Deadline()); }
+protected:
+	boost::scoped_ptr<IConvolutionEngine> engine_;
+	const char* name_;
+	vectorMat features_;
+	vector2DMat responses_;
+	boost::scoped_ptr<IConvolutionEngine::Workspace> workspace_;
+};
+
+class FourierKernel : public ConvolutionKernel {
+public:
+	FourierKernel(int type, const Size& size, const Options& options, RNG& rng) :
+		ConvolutionKernel(new FourierConvolutionEngine(padded(size, options), type, options.flen), "fourier", type, size, options, rng) {
+		const Size fft = padded(size, options);
+		const double N = fft.area();
+		const double C = options.flen;
+		const double transform = 5.0 * N * log2(N);
+		bytes = CV_ELEM_SIZE(type) * (size.area() * C + N * C + size.area());
+		flops = (C + 1) * transform + 6.0 * N/2 * C;
+	}
+private:
+	static Size padded(const Size& size, const Options& options) {
+		return Size(getOptimalDFTSize(size.width + options.filter), getOptimalDFTSize(size.height + options.filter));
+	}
+};
+
+/*! @brief the generalized distance transform of a score map
+ *
+ * two passes of the lower envelope, each reading and writing a score
+ * and writing an argument, with 8 flops to intersect and 4 to evaluate
+ * the parabolas per element per pass
+ */
+template<typename T>
+class DistanceTransformKernel : public Kernel {
+public:
+	DistanceTransformKernel(const Size& size, RNG& rng) : score_(size), fx_(0.01, 0), fy_(0.01, 0) {
+		rng.fill(score_, RNG::UNIFORM, Scalar::all(-1), Scalar::all(1));
+		elements = size.area();
+		bytes = 2.0 * size.area() * (2 * sizeof(T) + sizeof(int));
+		flops = 2.0 * size.area() * 12;
+	}
+	const char* name(void) const { return "distance_transform"; }
+	void run(void) { dt_.compute(score_, fx_, fy_, Point(0, 0), out_, Ix_, Iy_); }
+private:
+	DistanceTransform<T> dt_;
+	Mat_<T> score_;
+	Quadratic fx_;
+	Quadratic fy_;
+	Mat_<T> out_;
+	Mat_<int> Ix_;
+	Mat_<int> Iy_;
+};
+
+/*! @brief the elementwise max over the mixtures: one comparison per element per mixture */
+template<typename T>
+class ReduceMaxKernel : public Kernel {
+public:
+	ReduceMaxKernel(const Size& size, const Options& options, RNG& rng) : in_(options.mixtures) {
+		for (size_t k = 0; k < in_.size(); ++k) {
+			in_[k].create(size, DataType<T>::type);
+			rng.fill(in_[k], RNG::UNIFORM, Scalar::all(-1), Scalar::all(1));
+		}
+		elements = size.area();
+		bytes = size.area() * (in_.size() * sizeof(T) + sizeof(T) + sizeof(int));
+		flops = (double)size.area() * in_.size();
+	}
+	const char* name(void) const { return "reduce_max"; }
+	void run(void) { Math::reduceMax<T>(in_, maxv_, maxi_); }
+private:
+	vectorMat in_;
+	Mat maxv_;
+	Mat maxi_;
+};
+
+/*! @brief the gather of one mixture per element: an index, a picked value and a write */
+template<typename T>
+class ReducePickIndexKernel : public Kernel {
+public:
+	ReducePickIndexKernel(const Size& size, const Options& options, RNG& rng) : in_(options.mixtures), idx_(size, DataType<int>::type) {
+		for (size_t k = 0; k < in_.size(); ++k) {
+			in_[k].create(size, DataType<T>::type);
+			rng.fill(in_[k], RNG::UNIFORM, Scalar::all(-1), Scalar::all(1));
+		}
+		rng.fill(idx_, RNG::UNIFORM, Scalar::all(0), Scalar::all(options.mixtures));
+		elements = size.area();
+		bytes = size.area() * (sizeof(int) + 2 * sizeof(T));
+	}
+	const char* name(void) const { return "reduce_pick_index"; }
+	void run(void) { Math::reducePickIndex<T>(in_, idx_, out_); }
+private:
+	vectorMat in_;
+	Mat idx_;
+	Mat out_;
+};
+
+/*! @brief the nonzero elements of a thresholded map, 1% of which are set */
+class FindKernel : public Kernel {
+public:
+	FindKernel(const Size& size, RNG& rng) : binary_(size, CV_8U) {
+		Mat uniform(size, CV_32F);
+		rng.fill(uniform, RNG::UNIFORM, Scalar::all(0), Scalar::all(1));
+		binary_ = uniform > 0.99;
+		elements = size.area();
+		bytes = size.area() + countNonZero(binary_) * sizeof(Point);
+	}
+	const char* name(void) const { return "find"; }
+	void run(void) { idx_.clear(); Math::find(binary_, idx_); }
+private:
+	Mat binary_;
+	vector<Point> idx_;
+};
+
+/*! @brief greedy non-maxima suppression of one candidate per 16x16 block of the map
+ *
+ * the candidates are copied and sorted each run, then each survivor
+ * is compared against the remainder at ~10 flops per overlap test
+ */
+class NonMaximaSuppressionKernel : public Kernel {
+public:
+	NonMaximaSuppressionKernel(const Size& size, RNG& rng) {
+		const int N = std::max(size.area() / 256, 1);
+		for (int n = 0; n < N; ++n) {
+			Candidate candidate;
+			const int x = rng.uniform(0, size.width);
+			const int y = rng.uniform(0, size.height);
+			candidate.addPart(Rect(x, y, 32, 32), 0);
+			candidate.setScore(rng.uniform(-1.0f, 1.0f));
+			candidate.setComponent(0);
+			candidates_.push_back(candidate);
+		}
+		elements = N;
+		bytes = N * 2.0 * sizeof(Candidate);
+		flops = N * log2((double)N) + N * std::min(N, 64) * 10.0;
+	}
+	const char* name(void) const { return "nms"; }
+	void run(void) {
+		vectorCandidate candidates(candidates_);
+		Candidate::nonMaximaSuppression(candidates, 0.5f);
+	}
+private:
+	vectorCandidate candidates_;
+};
+
+/*! @brief the best time of a single run of a kernel
+ *
+ * the kernel is run once to warm the caches and allocate its outputs, then
+ * in batches of doubling size until a batch lasts the given time. The best
+ * of three such batches is reported, to reject interference from the host
+ */
+static double best(Kernel& kernel, double seconds) {
+	kernel.run();
+	size_t reps = 1;
+	double elapsed = 0;
+	for (;;) {
+		const int64 start = getTickCount();
+		for (size_t r = 0; r < reps; ++r) kernel.run();
+		elapsed = (getTickCount() - start) / getTickFrequency();
+		if (elapsed >= seconds || reps >= (1 << 24)) break;
+		reps *= 2;
+	}
+	double fastest = elapsed / reps;
+	for (int trial = 0; trial < 2; ++trial) {
+		const int64 start = getTickCount();
+		for (size_t r = 0; r < reps; ++r) kernel.run();
+		fastest = std::min(fastest, (getTickCount() - start) / getTickFrequency() / reps);
+	}
+	return fastest;
+}
+
+/*! @brief the sustainable memory bandwidth of the host, in GB/s
+ *
+ * a STREAM triad, a[i] = b[i] + s*c[i], over arrays well beyond the last
+ * level cache. Write-allocate traffic is not counted, as in STREAM
+ */
+static double measureBandwidth(double seconds) {
+	const size_t N = 1 << 23;
+	vector<double> a(N, 0), b(N, 1), c(N, 2);
+	const double s = 3;
+	double fastest = 1e300;
+	const int64 until = getTickCount() + (int64)(seconds * getTickFrequency());
+	for (int trial = 0; trial < 3 || getTickCount() < until; ++trial) {
+		const int64 start = getTickCount();
+#ifdef _OPENMP
+		#pragma omp parallel for
+#endif
+		for (long i = 0; i < (long)N; ++i) a[i] = b[i] + s*c[i];
+		fastest = std::min(fastest, (getTickCount() - start) / getTickFrequency());
+	}
+	return 3.0 * N * sizeof(double) / fastest / 1e9;
+}
+
+/*! @brief the arithmetic peak of the host, in GFLOP/s
+ *
+ * independent multiply-add chains, enough to hide the latency of the
+ * floating point unit. This is the peak the compiler can reach for plain
+ * code with the flags of this build, not the theoretical peak of the chip
+ */
+static double measureFlops(double seconds) {
+	const int K = 16;
+	const long iterations = 1 << 22;
+	double fastest = 1e300;
+	volatile float sink = 0;
+	int threads = 1;
+	const int64 until = getTickCount() + (int64)(seconds * getTickFrequency());
+	for (int trial = 0; trial < 3 || getTickCount() < until; ++trial) {
+		const int64 start = getTickCount();
+#ifdef _OPENMP
+		#pragma omp parallel
+#endif
+		{
+			float acc[K];
+			for (int k = 0; k < K; ++k) acc[k] = (float)k;
+			const float a = 0.999f, b = 0.001f;
+			for (long i = 0; i < iterations; ++i) {
+				for (int k = 0; k < K; ++k) acc[k] = acc[k]*a + b;
+			}
+			float sum = 0;
+			for (int k = 0; k < K; ++k) sum += acc[k];
+#ifdef _OPENMP
+			#pragma omp critical
+#endif
+			{
+#ifdef _OPENMP
+				threads = omp_get_num_threads();
+#endif
+				sink = sink + sum;
+			}
+		}
+		fastest = std::min(fastest, (getTickCount() - start) / getTickFrequency());
+	}
+	return 2.0 * K * iterations * threads / fastest / 1e9;
+}
+
+/*! @brief construct a kernel by name, or NULL if it is unknown */
+template<typename T>
+static Kernel* create(const string& name, const Size& size, const Options& options, RNG& rng) {
+	if (name == "hog") return new HOGKernel<T>(size, options, rng);
+	if (name == "spatial") return new ConvolutionKernel(new SpatialConvolutionEngine(DataType<T>::type, options.flen), "spatial", DataType<T>::type, size, options, rng);
+	if (name == "fourier") return new FourierKernel(DataType<T>::type, size, options, rng);
+	if (name == "distance_transform") return new DistanceTransformKernel<T>(size, rng);
+	if (name == "reduce_max") return new ReduceMaxKernel<T>(size, options, rng);
+	if (name == "reduce_pick_index") return new ReducePickIndexKernel<T>(size, options, rng);
+	if (name == "find") return new FindKernel(size, rng);
+	if (name == "nms") return new NonMaximaSuppressionKernel(size, rng);
+	return NULL;
+}
+
+/*! @brief time every kernel at every size at one precision, and write the results */
+template<typename T>
+static void run(const Options& options, const Roofline& roofline, const char* precision, bool& first) {
+
+	RNG rng(options.seed);
+	for (size_t k = 0; k < options.kernels.size(); ++k) {
+		for (size_t s = 0; s < options.sizes.size(); ++s) {
+			boost::scoped_ptr<Kernel> kernel(create<T>(options.kernels[k], options.sizes[s], options, rng));
+			if (!kernel) {
+				fprintf(stderr, "Unknown kernel %s\n", options.kernels[k].c_str());
+				break;
+			}
+			const double seconds = best(*kernel, options.seconds);
+			const double gbs = kernel->bytes / seconds / 1e9;
+			const double gflops = kernel->flops / seconds / 1e9;
+			const double intensity = kernel->bytes > 0 ? kernel->flops / kernel->bytes : 0;
+			const double attainable = roofline.attainable(intensity);
+			const bool memory = intensity < roofline.ridge();
+			const double efficiency = memory ? gbs / roofline.bandwidth : gflops / roofline.gflops;
+			printf("%s\n    {\"kernel\": \"%s\", \"precision\": \"%s\", \"size\": \"%dx%d\", \"seconds\": %.9f,\n",
+					first ? "" : ",", kernel->name(), precision, options.sizes[s].width, options.sizes[s].height, seconds);
+			printf("     \"ns_per_element\": %.4f, \"gbs\": %.3f, \"gflops\": %.3f, \"intensity\": %.4f,\n",
+					seconds * 1e9 / kernel->elements, gbs, gflops, intensity);
+			printf("     \"attainable_gflops\": %.3f, \"bound\": \"%s\", \"efficiency\": %.4f}",
+					attainable, memory ? "memory" : "compute", efficiency);
+			fflush(stdout);
+			first = false;
+		}
+	}
+}
+
+/*! @brief parse a comma separated list of sizes, such as 64x64,256x256 */
+static bool parseSizes(const string& arg, vector<Size>& sizes) {
+	vector<string> items;
+	boost::split(items, arg, boost::is_any_of(","));
+	for (size_t n = 0; n < items.size(); ++n) {
+		int width, height;
+		if (sscanf(items[n].c_str(), "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) return false;
+		sizes.push_back(Size(width, height));
+	}
+	return true;
+}
+
+static void usage(void) {
+	printf("Usage: PartsBasedDetector_microbench [options]\n"
+		"  --sizes WxH[,WxH...]      sizes of the input of each kernel. Images for hog, feature\n"
+		"                            maps for the convolutions, score maps otherwise\n"
+		"                            (default 64x64,256x256,1024x1024)\n"
+		"  --kernels K[,K...]        hog, spatial, fourier, distance_transform, reduce_max,\n"
+		"                            reduce_pick_index, find, nms (default all)\n"
+		"  --precision P[,P...]      float, double or both (default float)\n"
+		"  --flen N                  feature channels of the convolutions (default 32)\n"
+		"  --filter N                filter width and height of the convolutions (default 5)\n"
+		"  --mixtures N              mixtures of the reductions (default 8)\n"
+		"  --threads N               OpenMP threads of the kernels and the peaks (default 1)\n"
+		"  --seconds S               minimum duration of a timed batch (default 0.1)\n"
+		"  --seed S                  seed of the random inputs (default 0)\n");
+}
+
+int main(int argc, char** argv) {
+
+	// check arguments
+	Options options;
+	for (int n = 1; n < argc; ++n) {
+		const string arg(argv[n]);
+		const bool value = n+1 < argc;
+		if (arg == "--sizes" && value) {
+			if (!parseSizes(argv[++n], options.sizes)) { usage(); exit(-1); }
+		} else if (arg == "--kernels" && value) {
+			boost::split(options.kernels, argv[++n], boost::is_any_of(","));
+		} else if (arg == "--precision" && value) {
+			boost::split(options.precisions, argv[++n], boost::is_any_of(","));
+		} else if (arg == "--flen" && value) {
+			options.flen = std::max(atoi(argv[++n]), 1);
+		} else if (arg == "--filter" && value) {
+			options.filter = std::max(atoi(argv[++n]), 1);
+		} else if (arg == "--mixtures" && value) {
+			options.mixtures = std::max(atoi(argv[++n]), 1);
+		} else if (arg == "--threads" && value) {
+			options.threads = std::max(atoi(argv[++n]), 1);
+		} else if (arg == "--seconds" && value) {
+			options.seconds = atof(argv[++n]);
+		} else if (arg == "--seed" && value) {
+			options.seed = atoi(argv[++n]);
+		} else {
+			usage();
+			exit(-1);
+		}
+	}
+	if (options.sizes.empty()) {
+		options.sizes.push_back(Size(64, 64));
+		options.sizes.push_back(Size(256, 256));
+		options.sizes.push_back(Size(1024, 1024));
+	}
+	if (options.kernels.empty()) {
+		const char* all[] = { "hog", "spatial", "fourier", "distance_transform", "reduce_max", "reduce_pick_index", "find", "nms" };
+		options.kernels.assign(all, all + sizeof(all)/sizeof(all[0]));
+	}
+	if (options.precisions.empty()) options.precisions.push_back("float");
+	if (options.precisions.size() == 1 && options.precisions[0] == "both") {
+		options.precisions.clear();
+		options.precisions.push_back("float");
+		options.precisions.push_back("double");
+	}
+#ifdef _OPENMP
+	omp_set_num_threads(options.threads);
+#else
+	options.threads = 1;
+#endif
+
+	// measure the roof before the kernels, at the same thread count
+	Roofline roofline;
+	roofline.bandwidth = measureBandwidth(options.seconds);
+	roofline.gflops = measureFlops(options.seconds);
+	printf("{\n  \"threads\": %d,\n  \"host\": {\"bandwidth_gbs\": %.3f, \"peak_gflops\": %.3f, \"ridge\": %.4f},\n  \"kernels\": [",
+			options.threads, roofline.bandwidth, roofline.gflops, roofline.ridge());
+
+	bool first = true;
+	for (size_t p = 0; p < options.precisions.size(); ++p) {
+		if (options.precisions[p] == "float") run<float>(options, roofline, "float", first);
+		else if (options.precisions[p] == "double") run<double>(options, roofline, "double", first);
+		else fprintf(stderr, "Unknown precision %s\n", options.precisions[p].c_str());
+	}
+	printf("\n  ]\n}\n");
+	return 0;
+}
@@ -35,7 +35,13 @@
  *  Author:  Hilton Bristow
  *  Created: Jul 19, 2012
  */
+#include <algorithm>
+#include <cfloat>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "nms.hpp"
+#include "Trace.hpp"
 using namespace std;
 using namespace cv;
 
@@ -82,13 +88,31 @@ using namespace cv;
  * @param mask an input mask to skip particular elements
  */
 void nonMaximaSuppression(const Mat& src, const int sz, Mat& dst, const Mat mask) {
+	Mat neighbours;
+	nonMaximaSuppression(src, sz, dst, mask, neighbours);
+}
+
+/*! @brief suppress non-maximal values, reusing the working buffer
+ *
+ * As nonMaximaSuppression() above. dst and neighbours are only allocated if
+ * their size has changed since the last call with the same buffers
+ *
+ * @param src the input image/matrix, of any valid cv type
+ * @param sz the size of the window
+ * @param dst the mask of type CV_8U, where non-zero elements correspond to
+ * local maxima of the src
+ * @param mask an input mask to skip particular elements, or an empty matrix
+ * @param neighbours working storage for the mask of the neighbours of a block
+ */
+void nonMaximaSuppression(const Mat& src, const int sz, Mat& dst, const Mat& mask, Mat& neighbours) {
 
-	// initialise the block mask and destination
+	// initialise the neighbour mask and destination
 	const size_t M = src.rows;
 	const size_t N = src.cols;
 	const bool masked = !mask.empty();
-	Mat block = 255*Mat_<uint8_t>::ones(Size(2*sz+1,2*sz+1));
-	dst = Mat_<uint8_t>::zeros(src.size());
+	neighbours.create(Size(2*sz+1,2*sz+1), CV_8U);
+	dst.create(src.size(), CV_8U);
+	dst.setTo(0);
 
 	// iterate over image blocks
 	for (size_t m = 0; m < M; m+=sz+1) {
@@ -104,6 +128,8 @@ void nonMaximaSuppression(const Mat& src, const int sz, Mat& dst, const Mat mask
 			else
 				minMaxLoc(src(ic,jc), NULL, &vcmax, NULL, &ijmax, noArray());
 
+			// the block is entirely masked
+			if (ijmax.x < 0) continue;
 			Point cc = ijmax + Point(jc.start,ic.start);
 
 			// search the neighbours centered around the candidate for the true maxima
@@ -111,19 +137,152 @@ void nonMaximaSuppression(const Mat& src, const int sz, Mat& dst, const Mat mask
 			Range jn(max(cc.x-sz,0), min((size_t)cc.x+sz+1,N));
 
 			// mask out the block whose maxima we already know
-			Mat_<uint8_t> blockmask;
-			block(Range(0,in.size()), Range(0,jn.size())).copyTo(blockmask);
+			Mat blockmask = neighbours(Range(0,in.size()), Range(0,jn.size()));
+			if (masked) mask(in,jn).copyTo(blockmask);
+			else blockmask.setTo(255);
 			Range iis(ic.start-in.start, min(ic.start-in.start+sz+1, in.size()));
 			Range jis(jc.start-jn.start, min(jc.start-jn.start+sz+1, jn.size()));
-			blockmask(iis, jis) = Mat_<uint8_t>::zeros(Size(jis.size(),iis.size()));
+			blockmask(iis, jis).setTo(0);
 
-			minMaxLoc(src(in,jn), NULL, &vnmax, NULL, &ijmax, masked ? mask(in,jn).mul(blockmask) : blockmask);
+			vnmax = -DBL_MAX;
+			ijmax = Point(-1,-1);
+			minMaxLoc(src(in,jn), NULL, &vnmax, NULL, &ijmax, blockmask);
 			//Point cn = ijmax + Point(jn.start, in.start);
 
-			// if the block centre is also the neighbour centre, then it's a local maxima
-			if (vcmax > vnmax) {
+			// if the block centre is also the neighbour centre, then it's a local maxima.
+			// minMaxLoc() reports 0 when every neighbour is masked, so an empty
+			// neighbourhood is a maxima whatever the sign of the candidate
+			if (ijmax.x < 0 || vcmax > vnmax) {
 				dst.at<uint8_t>(cc.y, cc.x) = 255;
 			}
 		}
 	}
 }
+
+/*! @brief test whether a box overlaps any of a set of boxes
+ *
+ * The intersection over union of the box with each of the other boxes is
+ * compared to the overlap threshold without division, as
+ * intersection > overlap * union. The boxes are tested 4 at a time with SSE
+ *
+ * @param box the box, as (x1, y1, x2, y2, area)
+ * @param x1 the left edges of the other boxes
+ * @param y1 the top edges of the other boxes
+ * @param x2 the right edges (exclusive) of the other boxes
+ * @param y2 the bottom edges (exclusive) of the other boxes
+ * @param area the areas of the other boxes
+ * @param N the number of other boxes
+ * @param overlap the IoU threshold
+ * @return true if the IoU with any of the other boxes exceeds the threshold
+ */
+static bool overlapsAny(const float box[5], const float* x1, const float* y1, const float* x2, const float* y2,
+		const float* area, const size_t N, const float overlap) {
+
+	size_t n = 0;
+#ifdef __SSE2__
+	const __m128 bx1 = _mm_set1_ps(box[0]);
+	const __m128 by1 = _mm_set1_ps(box[1]);
+	const __m128 bx2 = _mm_set1_ps(box[2]);
+	const __m128 by2 = _mm_set1_ps(box[3]);
+	const __m128 barea = _mm_set1_ps(box[4]);
+	const __m128 thresh = _mm_set1_ps(overlap);
+	const __m128 zero = _mm_setzero_ps();
+	for (; n+4 <= N; n+=4) {
+		__m128 w = _mm_sub_ps(_mm_min_ps(bx2, _mm_loadu_ps(x2+n)), _mm_max_ps(bx1, _mm_loadu_ps(x1+n)));
+		__m128 h = _mm_sub_ps(_mm_min_ps(by2, _mm_loadu_ps(y2+n)), _mm_max_ps(by1, _mm_loadu_ps(y1+n)));
+		__m128 intersection = _mm_mul_ps(_mm_max_ps(w, zero), _mm_max_ps(h, zero));
+		__m128 uni = _mm_sub_ps(_mm_add_ps(barea, _mm_loadu_ps(area+n)), intersection);
+		if (_mm_movemask_ps(_mm_cmpgt_ps(intersection, _mm_mul_ps(thresh, uni)))) return true;
+	}
+#endif
+	for (; n < N; ++n) {
+		const float w = std::min(box[2], x2[n]) - std::max(box[0], x1[n]);
+		const float h = std::min(box[3], y2[n]) - std::max(box[1], y1[n]);
+		const float intersection = std::max(w, 0.0f) * std::max(h, 0.0f);
+		if (intersection > overlap * (box[4] + area[n] - intersection)) return true;
+	}
+	return false;
+}
+
+/*! @brief greedy intersection over union non-maximum suppression of boxes
+ *
+ * The boxes are visited in order, and a box is kept if its intersection over
+ * union with every previously kept box is at most overlap. The kept boxes are
+ * bucketed into a uniform grid with cells the size of an average box, so each
+ * box is only compared against the kept boxes in the cells it covers, rather
+ * than against every kept box or every pixel
+ *
+ * @param boxes the boxes, sorted from best to worst
+ * @param overlap the maximum intersection over union of two kept boxes
+ * @param keep the output indices of the kept boxes, in order
+ * @param maxdetections stop once this many boxes are kept. 0 for no limit
+ */
+void boxNonMaximaSuppression(const vector<Rect>& boxes, const float overlap, vectori& keep, const size_t maxdetections) {
+
+	TRACE_SPAN("boxNms");
+	keep.clear();
+	const size_t N = boxes.size();
+	if (N == 0) return;
+
+	// the extent of the boxes and the grid cell size
+	int xmin = boxes[0].x, ymin = boxes[0].y, xmax = boxes[0].br().x, ymax = boxes[0].br().y;
+	double extent = 0;
+	for (size_t n = 0; n < N; ++n) {
+		xmin = std::min(xmin, boxes[n].x);
+		ymin = std::min(ymin, boxes[n].y);
+		xmax = std::max(xmax, boxes[n].br().x);
+		ymax = std::max(ymax, boxes[n].br().y);
+		extent += std::max(boxes[n].width, boxes[n].height);
+	}
+	int cell = std::max(1, (int)(extent / N));
+	// bound the size of the grid for boxes which are small relative to their spread
+	while ((double)((xmax-xmin)/cell + 1) * ((ymax-ymin)/cell + 1) > 16.0*N + 64) cell *= 2;
+	const int gw = (xmax-xmin)/cell + 1;
+	const int gh = (ymax-ymin)/cell + 1;
+	vector2Di grid(gw*gh);
+
+	// the kept boxes, as a structure of arrays
+	vectorf kx1, ky1, kx2, ky2, karea;
+	kx1.reserve(N); ky1.reserve(N); kx2.reserve(N); ky2.reserve(N); karea.reserve(N);
+
+	// the kept boxes near the current box, gathered for comparison
+	vectori stamp(N, -1);
+	vectorf nx1, ny1, nx2, ny2, narea;
+
+	for (size_t n = 0; n < N; ++n) {
+		const Rect& r = boxes[n];
+		const float box[5] = { (float)r.x, (float)r.y, (float)r.br().x, (float)r.br().y, (float)r.area() };
+		const int cx1 = (r.x - xmin) / cell;
+		const int cy1 = (r.y - ymin) / cell;
+		const int cx2 = (std::max(r.br().x-1, r.x) - xmin) / cell;
+		const int cy2 = (std::max(r.br().y-1, r.y) - ymin) / cell;
+
+		// gather each nearby kept box once
+		nx1.clear(); ny1.clear(); nx2.clear(); ny2.clear(); narea.clear();
+		for (int cy = cy1; cy <= cy2; ++cy) {
+			for (int cx = cx1; cx <= cx2; ++cx) {
+				const vectori& bucket = grid[cy*gw + cx];
+				for (size_t i = 0; i < bucket.size(); ++i) {
+					const int k = bucket[i];
+					if (stamp[k] == (int)n) continue;
+					stamp[k] = n;
+					nx1.push_back(kx1[k]); ny1.push_back(ky1[k]);
+					nx2.push_back(kx2[k]); ny2.push_back(ky2[k]);
+					narea.push_back(karea[k]);
+				}
+			}
+		}
+		if (!narea.empty() && overlapsAny(box, &nx1[0], &ny1[0], &nx2[0], &ny2[0], &narea[0], narea.size(), overlap)) continue;
+
+		// keep the box and add it to the cells it covers
+		const int k = kx1.size();
+		kx1.push_back(box[0]); ky1.push_back(box[1]);
+		kx2.push_back(box[2]); ky2.push_back(box[3]);
+		karea.push_back(box[4]);
+		for (int cy = cy1; cy <= cy2; ++cy) {
+			for (int cx = cx1; cx <= cx2; ++cx) grid[cy*gw + cx].push_back(k);
+		}
+		keep.push_back(n);
+		if (maxdetections > 0 && keep.size() >= maxdetections) break;
+	}
+}
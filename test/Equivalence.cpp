@@ -0,0 +1,558 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    Equivalence.cpp
+ *  Created: Oct 19, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <boost/filesystem.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#if CV_MAJOR_VERSION >= 3
+#include <opencv2/imgcodecs.hpp>
+#else
+#include <opencv2/highgui/highgui.hpp>
+#endif
+#include "PartsBasedDetector.hpp"
+#include "DetectionWorkspace.hpp"
+#include "HOGFeatures.hpp"
+#include "SpatialConvolutionEngine.hpp"
+#include "FourierConvolutionEngine.hpp"
+#include "DistanceTransform.hpp"
+#include "SyntheticModel.hpp"
+using namespace cv;
+using namespace std;
+
+/*
+ * Checks that the optimized implementation of each stage of the pipeline
+ * agrees with a reference implementation, on synthetic and real images:
+ *
+ *   features    HOGFeatures<float> against HOGFeatures<double>. This is the same
+ *               code at two precisions, so it checks precision, not equivalence
+ *   responses   the spatial and Fourier engines against a direct correlation
+ *   dt          DistanceTransform<float|double> against a brute force maximum,
+ *               and the score at each argmin against the maximum
+ *   detections  float, fixed point and batched detection against double
+ *   pruning     pruned detection against exhaustive detection, which must agree exactly
+ *
+ * Deviations are relative to the largest magnitude of the reference, or 1 if
+ * that is smaller. Detections are matched by component and root box, and
+ * pass if enough of them match and the scores of the matches agree
+ */
+
+/*! @brief the tolerances of each comparison
+ *
+ * The single precision stages deviate from double by about 1e-7 relative
+ * (features 8e-8, responses 3e-7, distance transform 2e-8, and 1e-7 for a sum
+ * of part scores). Their tolerances leave two orders of magnitude, and three
+ * for the detection scores, which accumulate messages down the whole tree.
+ * Fixed point rounds each part score to 1/4096, which sums to about 2e-3 over
+ * the 68 parts of the face model
+ */
+struct Tolerances {
+	Tolerances() : features(1e-5), responses(1e-5), dt(1e-5), argmin(1e-5), scores(1e-4), fixed(1e-2), match(0.95), fixed_match(0.9) {}
+	double features;
+	double responses;
+	double dt;
+	double argmin;
+	double scores;
+	double fixed;
+	double match;
+	double fixed_match;
+	/*! @brief set a tolerance from name=value */
+	bool set(const string& assignment) {
+		const size_t eq = assignment.find('=');
+		if (eq == string::npos) return false;
+		const string name = assignment.substr(0, eq);
+		const double value = atof(assignment.c_str() + eq + 1);
+		if (name == "features") features = value;
+		else if (name == "responses") responses = value;
+		else if (name == "dt") dt = value;
+		else if (name == "argmin") argmin = value;
+		else if (name == "scores") scores = value;
+		else if (name == "fixed") fixed = value;
+		else if (name == "match") match = value;
+		else if (name == "fixed_match") fixed_match = value;
+		else return false;
+		return true;
+	}
+};
+
+/*! @brief the deviation of an optimized output from the reference */
+struct Deviation {
+	Deviation() : max(0), sum(0), count(0), magnitude(0), mismatched(false) {}
+	double max;
+	double sum;
+	size_t count;
+	double magnitude;
+	bool mismatched;
+	void add(const Mat& reference, const Mat& optimized) {
+		if (reference.size() != optimized.size() || reference.channels() != optimized.channels()) {
+			mismatched = true;
+			return;
+		}
+		if (reference.empty()) return;
+		Mat r, o, diff;
+		reference.reshape(1).convertTo(r, CV_64F);
+		optimized.reshape(1).convertTo(o, CV_64F);
+		absdiff(r, o, diff);
+		double dmax, rmin, rmax;
+		minMaxLoc(diff, NULL, &dmax);
+		minMaxLoc(r, &rmin, &rmax);
+		max = std::max(max, dmax);
+		magnitude = std::max(magnitude, std::max(fabs(rmin), fabs(rmax)));
+		sum += cv::sum(diff)[0];
+		count += diff.total();
+	}
+	void add(double reference, double optimized) {
+		const double d = fabs(reference - optimized);
+		max = std::max(max, d);
+		magnitude = std::max(magnitude, fabs(reference));
+		sum += d;
+		count++;
+	}
+	double mean(void) const { return count ? sum / count : 0; }
+	double relative(void) const { return max / std::max(magnitude, 1.0); }
+};
+
+/*! @brief print a deviation report, returning 1 if it is out of tolerance */
+static int report(const string& name, const Deviation& deviation, double tolerance) {
+	const bool pass = !deviation.mismatched && deviation.relative() <= tolerance;
+	printf("  %-40s max %10.3e  mean %10.3e  rel %10.3e  tol %8.1e  %s\n", name.c_str(), deviation.max, deviation.mean(),
+			deviation.relative(), tolerance, deviation.mismatched ? "SIZE MISMATCH" : pass ? "ok" : "FAIL");
+	return pass ? 0 : 1;
+}
+
+// ----------------------------------------------------------------------------
+// REFERENCE IMPLEMENTATIONS
+// ----------------------------------------------------------------------------
+
+/*! @brief direct correlation of a feature with a filter, anchored at the filter centre
+ *
+ * Outside the feature, every channel is zero except the last (truncation)
+ * channel, which is one
+ */
+static void correlate(const Mat& feature, const Mat& filter, int flen, Mat& response) {
+	Mat F, K;
+	feature.convertTo(F, CV_64F);
+	filter.convertTo(K, CV_64F);
+	const int H = F.rows, W = F.cols / flen;
+	const int kh = K.rows, kw = K.cols / flen;
+	const int ay = kh/2, ax = kw/2;
+	response.create(H, W, CV_64F);
+	for (int y = 0; y < H; ++y) {
+		for (int x = 0; x < W; ++x) {
+			double acc = 0;
+			for (int i = 0; i < kh; ++i) {
+				const int yy = y + i - ay;
+				for (int j = 0; j < kw; ++j) {
+					const int xx = x + j - ax;
+					const double* k = K.ptr<double>(i) + j*flen;
+					if (yy < 0 || yy >= H || xx < 0 || xx >= W) {
+						acc += k[flen-1];
+						continue;
+					}
+					const double* f = F.ptr<double>(yy) + xx*flen;
+					for (int c = 0; c < flen; ++c) acc += k[c] * f[c];
+				}
+			}
+			response.at<double>(y,x) = acc;
+		}
+	}
+}
+
+/*! @brief the deformation score of a displacement from the anchor */
+static double deformation(const vectorf& w, int dx, int dy) {
+	return -(w[0]*dx*dx + w[1]*dx + w[2]*dy*dy + w[3]*dy);
+}
+
+/*! @brief brute force distance transform: the best deformed score over every source location */
+static void distanceTransform(const Mat_<double>& in, const vectorf& w, const Point& os, Mat_<double>& out) {
+	out.create(in.size());
+	for (int y = 0; y < in.rows; ++y) {
+		for (int x = 0; x < in.cols; ++x) {
+			double best = -std::numeric_limits<double>::infinity();
+			for (int v = 0; v < in.rows; ++v) {
+				for (int u = 0; u < in.cols; ++u) {
+					best = std::max(best, in(v,u) + deformation(w, x + os.x - u, y + os.y - v));
+				}
+			}
+			out(y,x) = best;
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+// STAGES
+// ----------------------------------------------------------------------------
+
+/*! @brief the feature pyramid in single precision against double precision
+ *
+ * Both pyramids come from HOGFeatures, so this bounds the rounding of the
+ * single precision features rather than checking them against an independent
+ * implementation
+ */
+static int features(Model& model, const Mat& im, const Tolerances& tolerances, vectorMat& pyramid) {
+	HOGFeatures<double> reference(model.binsize(), model.nscales(), model.flen(), model.norient());
+	HOGFeatures<float> optimized(model.binsize(), model.nscales(), model.flen(), model.norient());
+	vectorMat expected;
+	vectorf expected_scales, scales;
+	reference.pyramid(im, expected, expected_scales);
+	optimized.pyramid(im, pyramid, scales);
+
+	Deviation deviation;
+	if (expected.size() != pyramid.size()) deviation.mismatched = true;
+	for (size_t n = 0; n < std::min(expected.size(), pyramid.size()); ++n) deviation.add(expected[n], pyramid[n]);
+	Deviation scale;
+	for (size_t n = 0; n < std::min(expected_scales.size(), scales.size()); ++n) scale.add(expected_scales[n], scales[n]);
+	return report(format("feature precision (%d levels)", (int)pyramid.size()), deviation, tolerances.features) +
+		   report("feature scale precision", scale, tolerances.features);
+}
+
+/*! @brief the responses of the engines against direct correlation
+ *
+ * @param expected the reference response of the first filter at the finest level
+ */
+static int responses(Model& model, const vectorMat& pyramid, const Tolerances& tolerances, Mat& expected) {
+
+	// a few filters of the model, and a fine and a coarse level
+	const int flen = model.flen();
+	vectorMat filters;
+	Size fsize(0, 0);
+	for (size_t n = 0; n < std::min(model.filters().size(), (size_t)8); ++n) {
+		Mat filter;
+		model.filters()[n].convertTo(filter, CV_32F);
+		filters.push_back(filter);
+		fsize.width  = std::max(fsize.width,  filter.cols / flen);
+		fsize.height = std::max(fsize.height, filter.rows);
+	}
+	vectori levels;
+	levels.push_back(0);
+	if (pyramid.size() > 2) levels.push_back(pyramid.size() / 2);
+	Size lsize(0, 0);
+	for (size_t l = 0; l < levels.size(); ++l) {
+		lsize.width  = std::max(lsize.width,  pyramid[levels[l]].cols / flen);
+		lsize.height = std::max(lsize.height, pyramid[levels[l]].rows);
+	}
+
+	SpatialConvolutionEngine spatial(CV_32F, flen);
+	FourierConvolutionEngine fourier(Size(lsize.width + fsize.width, lsize.height + fsize.height), CV_32F, flen);
+	spatial.setFilters(filters);
+	fourier.setFilters(filters);
+
+	Deviation sdev, fdev;
+	for (size_t l = 0; l < levels.size(); ++l) {
+		const vectorMat level(1, pyramid[levels[l]]);
+		vector2DMat sresponses, fresponses;
+		spatial.pdf(level, sresponses);
+		fourier.pdf(level, fresponses);
+		for (size_t n = 0; n < filters.size(); ++n) {
+			Mat reference;
+			correlate(level[0], filters[n], flen, reference);
+			sdev.add(reference, sresponses[0][n]);
+			fdev.add(reference, fresponses[0][n]);
+			if (l == 0 && n == 0) expected = reference;
+		}
+	}
+	return report(format("spatial responses (%d filters)", (int)filters.size()), sdev, tolerances.responses) +
+		   report(format("fourier responses (%d filters)", (int)filters.size()), fdev, tolerances.responses);
+}
+
+/*! @brief the distance transform and its argmins against brute force, at one precision */
+template<typename T>
+static int distanceTransform(const Mat_<double>& in, const vectorf& w, const Point& os, const Mat_<double>& expected, const Tolerances& tolerances, const char* precision) {
+	Mat_<T> score_in, score_out;
+	Mat_<int> Ix, Iy;
+	in.convertTo(score_in, DataType<T>::type);
+	DistanceTransform<T> dt;
+	dt.compute(score_in, Quadratic(-w[0], -w[1]), Quadratic(-w[2], -w[3]), os, score_out, Ix, Iy);
+
+	// the score at each argmin should be the maximum
+	Deviation scores, argmins;
+	scores.add(expected, score_out);
+	for (int y = 0; y < in.rows; ++y) {
+		for (int x = 0; x < in.cols; ++x) {
+			const int u = Ix(y,x), v = Iy(y,x);
+			if (u < 0 || u >= in.cols || v < 0 || v >= in.rows) { argmins.mismatched = true; continue; }
+			argmins.add(expected(y,x), in(v,u) + deformation(w, x + os.x - u, y + os.y - v));
+		}
+	}
+	return report(format("distance transform (%s)", precision), scores, tolerances.dt) +
+		   report(format("distance transform argmins (%s)", precision), argmins, tolerances.argmin);
+}
+
+static int distanceTransform(Model& model, const Mat& response, const Tolerances& tolerances) {
+
+	// the deformation of the first child of the first component, if there is one
+	vectorf w(4, 0.0f);
+	w[0] = w[2] = 0.01f;
+	Point os(0, 0);
+	if (model.ncomponents() > 0 && model.defid()[0].size() > 1) {
+		const int d = model.defid()[0][1][0];
+		w = model.def()[d];
+		os = model.anchors()[d];
+	}
+
+	Mat_<double> in = response, expected;
+	distanceTransform(in, w, os, expected);
+	return distanceTransform<double>(in, w, os, expected, tolerances, "double") +
+		   distanceTransform<float>(in, w, os, expected, tolerances, "float");
+}
+
+/*! @brief match the detections of an optimized path to those of the reference by component and root box */
+static int detections(const string& name, const Detections& reference, const Detections& optimized, double tolerance, double match) {
+	typedef vectori Key;
+	map<Key, size_t> index;
+	for (size_t i = 0; i < reference.size(); ++i) {
+		const Rect& root = reference.parts(i)[0];
+		const int values[] = { reference.component(i), root.x, root.y, root.width, root.height };
+		index[Key(values, values + 5)] = i;
+	}
+	size_t matched = 0, moved = 0;
+	Deviation scores;
+	for (size_t j = 0; j < optimized.size(); ++j) {
+		const Rect& root = optimized.parts(j)[0];
+		const int values[] = { optimized.component(j), root.x, root.y, root.width, root.height };
+		map<Key, size_t>::const_iterator it = index.find(Key(values, values + 5));
+		if (it == index.end()) continue;
+		const size_t i = it->second;
+		matched++;
+		scores.add(reference.score(i), optimized.score(j));
+		bool same = reference.nparts(i) == optimized.nparts(j);
+		for (size_t p = 0; same && p < reference.nparts(i); ++p) same = reference.parts(i)[p] == optimized.parts(j)[p];
+		if (!same) moved++;
+	}
+	const size_t total = std::max(reference.size(), optimized.size());
+	const double fraction = total ? (double)matched / total : 1.0;
+	printf("  %-40s %lu reference, %lu optimized, %lu matched (%.3f, min %.3f), %lu with moved parts\n", name.c_str(),
+			reference.size(), optimized.size(), matched, fraction, match, moved);
+	const int failures = report(name + " scores", scores, tolerance);
+	if (fraction < match) {
+		printf("  %-40s FAIL\n", (name + " matches").c_str());
+		return failures + 1;
+	}
+	return failures;
+}
+
+/*! @brief restore the filters of a model as they were loaded
+ *
+ * distributeModel() converts the filters of the model to the precision of the
+ * detector in place, so without this the double reference of every image after
+ * the first would be built from float-rounded filters
+ *
+ * @param model the model to restore
+ * @param filters the filters of the model as they were loaded
+ */
+static void restore(Model& model, const vectorMat& filters) {
+	model.filters().resize(filters.size());
+	for (size_t n = 0; n < filters.size(); ++n) filters[n].copyTo(model.filters()[n]);
+}
+
+static int detections(Model& model, const vectorMat& filters, const Mat& im, const Tolerances& tolerances, size_t topk) {
+
+	// each detector is distributed from the filters as they were loaded
+	PartsBasedDetector<double> reference;
+	restore(model, filters);
+	reference.distributeModel(model);
+	PartsBasedDetector<float> optimized;
+	restore(model, filters);
+	optimized.distributeModel(model);
+	PartsBasedDetector<float> fixed;
+	restore(model, filters);
+	fixed.distributeModel(model);
+	fixed.setFixedPoint(true);
+	reference.setRootSuppression(0, topk);
+	optimized.setRootSuppression(0, topk);
+	fixed.setRootSuppression(0, topk);
+
+	DetectionWorkspace workspaces[3];
+	Detections expected, single, quantized;
+	reference.detect(im, workspaces[0], expected);
+	optimized.detect(im, workspaces[1], single);
+	fixed.detect(im, workspaces[2], quantized);
+	std::vector<Detections> batch;
+	optimized.detect(vectorMat(1, im), batch);
+
+	return detections("detections (float)", expected, single, tolerances.scores, tolerances.match) +
+		   detections("detections (fixed point)", single, quantized, tolerances.fixed, tolerances.fixed_match) +
+		   detections("detections (batch)", single, batch[0], tolerances.scores, 1.0);
+}
+
+/*! @brief pruned detection against exhaustive detection
+ *
+ * Pruning is exact, so the detections must be identical with and without it.
+ * The threshold of a synthetic model is far below any score, where nothing can
+ * be pruned, so the threshold is raised to a quantile of the exhaustive root
+ * scores. The check fails if no root location was pruned
+ */
+static int pruning(Model& model, const vectorMat& filters, const Mat& im, size_t topk) {
+
+	// the scores of the exhaustive search
+	const float thresh = model.thresh();
+	PartsBasedDetector<float> detector;
+	restore(model, filters);
+	detector.distributeModel(model);
+	detector.setRootSuppression(0, topk);
+	detector.setPruning(false);
+	DetectionWorkspace workspace;
+	Detections exhaustive;
+	detector.detect(im, workspace, exhaustive);
+	if (exhaustive.empty()) {
+		printf("  %-40s FAIL (no detections to set the threshold from)\n", "pruning");
+		return 1;
+	}
+	vectorf scores(exhaustive.size());
+	for (size_t i = 0; i < exhaustive.size(); ++i) scores[i] = exhaustive.score(i);
+	const size_t rank = scores.size() * 3 / 4;
+	std::nth_element(scores.begin(), scores.begin() + rank, scores.end());
+
+	// search again with and without pruning at the raised threshold
+	model.setThresh(std::max(thresh, scores[rank]));
+	restore(model, filters);
+	detector.distributeModel(model);
+	detector.setRootSuppression(0, topk);
+	Detections pruned, unpruned;
+	detector.detect(im, workspace, pruned);
+	const double fraction = workspace.stats.prunedFraction();
+	detector.setPruning(false);
+	detector.detect(im, workspace, unpruned);
+	model.setThresh(thresh);
+
+	printf("  %-40s %.1f%% of the root locations at threshold %.3f\n", "pruned", fraction * 100, scores[rank]);
+	const int failures = detections("detections (pruned)", unpruned, pruned, 0, 1.0);
+	if (fraction == 0) {
+		printf("  %-40s FAIL (no root location was pruned)\n", "pruning");
+		return failures + 1;
+	}
+	return failures;
+}
+
+// ----------------------------------------------------------------------------
+// HARNESS
+// ----------------------------------------------------------------------------
+
+static void usage(void) {
+	printf("Usage: Equivalence [model_file] [options] [image_file ...]\n"
+		"  model_file               an .xml, .yaml (or .mat) model, or synthetic:face or\n"
+		"                           synthetic:person (default synthetic:person)\n"
+		"  --tolerance name=value   one of features, responses, dt, argmin, scores, fixed,\n"
+		"                           match or fixed_match\n");
+}
+
+int main(int argc, char** argv) {
+
+	// check arguments
+	string source = "synthetic:person";
+	Tolerances tolerances;
+	vector<string> files;
+	for (int n = 1; n < argc; ++n) {
+		const string arg(argv[n]);
+		const string ext = boost::filesystem::path(arg).extension().string();
+		if (arg == "--tolerance" && n+1 < argc) {
+			if (!tolerances.set(argv[++n])) { usage(); return -1; }
+		} else if (arg.compare(0, 2, "--") == 0) {
+			usage();
+			return -1;
+		} else if (n == 1 && (arg.compare(0, 10, "synthetic:") == 0 || ext == ".xml" || ext == ".yaml" || ext == ".mat")) {
+			source = arg;
+		} else {
+			files.push_back(arg);
+		}
+	}
+
+	// determine the type of model to read, or generate one. A synthetic model detects
+	// everywhere, and only the best root locations are kept, so that the detections
+	// stages always have candidates to compare
+	boost::scoped_ptr<Model> model(loadModel(source));
+	if (!model) return -2;
+	size_t topk = 0;
+	if (source.compare(0, 10, "synthetic:") == 0) {
+		model->setThresh(-1e3f);
+		topk = 100;
+	}
+
+	// synthetic inputs: noise, and smooth shapes over a gradient. Then the real images
+	vectorMat images;
+	vector<string> names;
+	RNG rng(0);
+	Mat noise(Size(192, 144), CV_8UC3);
+	rng.fill(noise, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+	images.push_back(noise);
+	names.push_back("synthetic noise");
+	Mat shapes(Size(192, 144), CV_8UC3);
+	for (int y = 0; y < shapes.rows; ++y) shapes.row(y).setTo(Scalar::all(y * 255 / shapes.rows));
+	for (int n = 0; n < 12; ++n) {
+		const Point centre(rng.uniform(0, shapes.cols), rng.uniform(0, shapes.rows));
+		const Scalar colour(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+		if (n % 2) circle(shapes, centre, rng.uniform(4, 32), colour, -1);
+		else rectangle(shapes, centre, centre + Point(rng.uniform(4, 48), rng.uniform(4, 48)), colour, -1);
+	}
+	GaussianBlur(shapes, shapes, Size(5, 5), 1.5);
+	images.push_back(shapes);
+	names.push_back("synthetic shapes");
+	for (size_t n = 0; n < files.size(); ++n) {
+		Mat im = imread(files[n]);
+		if (im.empty()) {
+			printf("Image not found or invalid image format: %s\n", files[n].c_str());
+			return -4;
+		}
+		images.push_back(im);
+		names.push_back(files[n]);
+	}
+
+	// run every stage on every input, from the filters as they were loaded
+	printf("model %s: %d components, %lu filters\n", model->name().c_str(), model->ncomponents(), model->filters().size());
+	vectorMat filters(model->filters().size());
+	for (size_t n = 0; n < filters.size(); ++n) filters[n] = model->filters()[n].clone();
+	int failures = 0;
+	for (size_t i = 0; i < images.size(); ++i) {
+		printf("%s (%dx%d)\n", names[i].c_str(), images[i].cols, images[i].rows);
+		restore(*model, filters);
+		vectorMat pyramid;
+		Mat response;
+		failures += features(*model, images[i], tolerances, pyramid);
+		failures += responses(*model, pyramid, tolerances, response);
+		failures += distanceTransform(*model, response, tolerances);
+		failures += detections(*model, filters, images[i], tolerances, topk);
+		failures += pruning(*model, filters, images[i], topk);
+	}
+	printf("%d comparisons out of tolerance\n", failures);
+	return failures;
+}
@@ -0,0 +1,124 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    RootSuppression.cpp
+ *  Created: Oct 19, 2026
+ */
+
+#include <stdio.h>
+#include <algorithm>
+#include <opencv2/core/core.hpp>
+#include "nms.hpp"
+#include "SearchSpacePruning.hpp"
+#include "Math.hpp"
+#include "types.hpp"
+using namespace cv;
+using namespace std;
+
+/*
+ * Checks that local maxima suppression keeps isolated peaks whose scores are
+ * negative. Model thresholds are below zero, so every neighbour of such a peak
+ * is masked out by the threshold, which must not count as a larger neighbour
+ */
+
+/*! @brief a map of low scores with isolated peaks above the threshold */
+template<typename T>
+static Mat_<T> peaks(const vectorPoint& locations, T background, T peak) {
+	Mat_<T> scores(Size(24, 20), background);
+	for (size_t n = 0; n < locations.size(); ++n) scores(locations[n]) = peak;
+	return scores;
+}
+
+/*! @brief check that exactly the peaks survive, and that the rest hold the given value */
+template<typename T>
+static int check(const char* name, const Mat& scores, const vectorPoint& locations, T peak, T suppressed) {
+	int failures = 0;
+	for (int y = 0; y < scores.rows; ++y) {
+		for (int x = 0; x < scores.cols; ++x) {
+			const bool expected = std::find(locations.begin(), locations.end(), Point(x, y)) != locations.end();
+			const T value = scores.at<T>(y, x);
+			if (value != (expected ? peak : suppressed)) failures++;
+		}
+	}
+	printf("%-28s %s\n", name, failures ? "FAILED" : "ok");
+	return failures ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+
+	// peaks within and across blocks, and on the borders
+	vectorPoint locations;
+	locations.push_back(Point(10, 10));
+	locations.push_back(Point(0, 0));
+	locations.push_back(Point(23, 3));
+	locations.push_back(Point(4, 19));
+	const int window = 3;
+	int failures = 0;
+
+	// the local maxima of a negative map, masked by a negative threshold
+	{
+		const Mat_<float> scores = peaks<float>(locations, -5.0f, -0.5f);
+		Mat maxima;
+		nonMaximaSuppression(scores, window, maxima, scores > -1.0);
+		failures += check<uint8_t>("nonMaximaSuppression", maxima, locations, 255, 0);
+	}
+
+	// root suppression keeps the peaks and lowers the rest, in floating point
+	{
+		SearchSpacePruning<float> ssp;
+		vector2DMat rootv(1, vectorMat(1));
+		rootv[0][0] = peaks<float>(locations, -5.0f, -0.5f);
+		ssp.nonMaxSuppression(rootv, -1.0, window, 0);
+		failures += check<float>("nonMaxSuppression float", rootv[0][0], locations, -0.5f, Math::lowest<float>());
+	}
+
+	// and in fixed point, where the lowest score is finite
+	{
+		SearchSpacePruning<float> ssp;
+		vector2DMat rootv(1, vectorMat(1));
+		rootv[0][0] = peaks<int>(locations, -5 * 4096, -4096 / 2);
+		ssp.nonMaxSuppression(rootv, -4096.0, window, 0);
+		failures += check<int>("nonMaxSuppression fixed", rootv[0][0], locations, -4096 / 2, Math::lowest<int>());
+	}
+
+	// the top k of the peaks
+	{
+		SearchSpacePruning<double> ssp;
+		vector2DMat rootv(1, vectorMat(1));
+		rootv[0][0] = peaks<double>(locations, -5.0, -0.5);
+		rootv[0][0].at<double>(locations[0]) = -0.25;
+		ssp.nonMaxSuppression(rootv, -1.0, window, 1);
+		failures += check<double>("nonMaxSuppression topk", rootv[0][0], vectorPoint(1, locations[0]), -0.25, Math::lowest<double>());
+	}
+	return failures;
+}
@@ -0,0 +1,181 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    VideoPipeline.cpp
+ *  Created: Oct 19, 2026
+ */
+
+#include <stdio.h>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include <boost/thread/thread.hpp>
+#include "PartsBasedDetector.hpp"
+#include "SyntheticModel.hpp"
+#include "VideoDetector.hpp"
+using namespace cv;
+using namespace std;
+
+/*
+ * Runs the video pipeline headless on a synthetic model, and checks that
+ * frames come out in the order they were pushed with the detections of a
+ * single call to detect(), that a full pipeline drops the oldest waiting
+ * frame (or the new one, if every frame has started), and that it shuts
+ * down with frames in flight
+ */
+
+/*! @brief a textured frame, tagged with its index in the first pixel */
+static Mat frame(Size size, int index) {
+	Mat im(size, CV_8UC3);
+	randu(im, Scalar::all(0), Scalar::all(255));
+	im.at<Vec3b>(0, 0) = Vec3b(index, index, index);
+	return im;
+}
+
+//! the index a frame was tagged with
+static int tag(const Mat& im) {
+	return im.at<Vec3b>(0, 0)[0];
+}
+
+/*! @brief wait for the next finished frame
+ *
+ * @return false if no frame finished within the timeout
+ */
+static bool pop(VideoDetector<float>& video, Detections& detections, Mat& im, double timeout = 60) {
+	const int64 start = getTickCount();
+	while (!video.pop(detections, im)) {
+		if ((getTickCount() - start) / getTickFrequency() > timeout) return false;
+		boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+	}
+	return true;
+}
+
+//! wait until a number of frames have finished, or the timeout expires
+static bool wait(const VideoDetector<float>& video, size_t completed, double timeout = 60) {
+	const int64 start = getTickCount();
+	while (video.completed() < completed) {
+		if ((getTickCount() - start) / getTickFrequency() > timeout) return false;
+		boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+
+	SyntheticModel model(SyntheticModel::face());
+	PartsBasedDetector<float> pbd;
+	pbd.distributeModel(model);
+	const Size size(160, 120);
+	int failures = 0;
+
+	// frames come out in order, with the detections of detect()
+	{
+		const int nframes = 8;
+		vectorMat images;
+		for (int n = 0; n < nframes; ++n) images.push_back(frame(size, n));
+		VideoDetector<float> video(pbd, 3);
+		int pushed = 0, popped = 0, mismatched = 0, disordered = 0;
+		bool accepted = true;
+		while (popped < nframes) {
+			// keep the pipeline full without dropping
+			if (pushed < nframes && pushed - popped < (int)video.depth()) {
+				accepted = video.push(images[pushed++]) && accepted;
+				continue;
+			}
+			Detections detections, expected;
+			Mat im;
+			if (!pop(video, detections, im)) break;
+			pbd.detect(images[popped], Mat(), expected);
+			if (tag(im) != popped) disordered++;
+			if (detections.size() != expected.size()) mismatched++;
+			popped++;
+		}
+		const bool ok = accepted && popped == nframes && !disordered && !mismatched && video.dropped() == 0;
+		printf("%-28s %s (%d of %d frames, %d out of order, %d with other detections)\n", "ordering", ok ? "ok" : "FAILED",
+				popped, nframes, disordered, mismatched);
+		if (!ok) failures++;
+	}
+
+	// once every frame has started, a new frame is dropped
+	{
+		VideoDetector<float> video(pbd, 2);
+		video.push(frame(size, 0));
+		video.push(frame(size, 1));
+		const bool finished = wait(video, 2);
+		const bool rejected = !video.push(frame(size, 2));
+		Detections detections;
+		Mat first, second;
+		const bool ok = finished && rejected && video.dropped() == 1 &&
+				pop(video, detections, first) && pop(video, detections, second) &&
+				tag(first) == 0 && tag(second) == 1 && !video.pop(detections);
+		printf("%-28s %s\n", "drop newest when started", ok ? "ok" : "FAILED");
+		if (!ok) failures++;
+	}
+
+	// otherwise the oldest waiting frame is dropped. The first frame is large, so
+	// the others wait behind it, but whether it has itself started is a race
+	{
+		bool observed = false, consistent = true;
+		for (int attempt = 0; attempt < 5 && !observed && consistent; ++attempt) {
+			VideoDetector<float> video(pbd, 2);
+			video.push(frame(Size(1280, 960), 0));
+			video.push(frame(size, 1));
+			const bool accepted = video.push(frame(size, 2));
+			vector<int> tags;
+			Detections detections;
+			Mat im;
+			while (tags.size() < 2 && pop(video, detections, im)) tags.push_back(tag(im));
+			// the newest frame replaced a waiting one, or was dropped if neither was waiting
+			const bool replaced = accepted && tags.size() == 2 && tags[0] < tags[1] && tags[1] == 2;
+			const bool started = !accepted && tags.size() == 2 && tags[0] == 0 && tags[1] == 1;
+			consistent = video.dropped() == 1 && (replaced || started);
+			observed = replaced;
+		}
+		const bool ok = observed && consistent;
+		printf("%-28s %s\n", "drop oldest when waiting", ok ? "ok" : "FAILED");
+		if (!ok) failures++;
+	}
+
+	// the pipeline stops with frames in flight, and when idle
+	{
+		const int64 start = getTickCount();
+		{
+			VideoDetector<float> video(pbd, 3);
+			for (int n = 0; n < 3; ++n) video.push(frame(size, n));
+		}
+		{
+			VideoDetector<float> idle(pbd, 3);
+		}
+		printf("%-28s ok (%.3f s)\n", "shutdown", (getTickCount() - start) / getTickFrequency());
+	}
+	return failures;
+}
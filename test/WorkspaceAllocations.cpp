@@ -0,0 +1,146 @@
+/* 
+ *  Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2012, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  File:    WorkspaceAllocations.cpp
+ *  Created: Oct 19, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <boost/scoped_ptr.hpp>
+#include <opencv2/core/core.hpp>
+#include "PartsBasedDetector.hpp"
+#include "DetectionWorkspace.hpp"
+#include "SyntheticModel.hpp"
+using namespace cv;
+using namespace std;
+
+/*
+ * Checks that a detector with a DetectionWorkspace prepared for a size does not
+ * allocate any matrices when it searches images of that size, from the first
+ * frame on, with and without root suppression. Every matrix allocation is
+ * counted by installing a counting allocator as the default allocator, which
+ * requires OpenCV 3 or later. Also checks that the memory
+ * accounts of the call match the buffers the workspace holds afterwards
+ */
+
+#if CV_MAJOR_VERSION >= 3
+#if CV_MAJOR_VERSION >= 4
+typedef AccessFlag AllocatorFlags;
+#else
+typedef int AllocatorFlags;
+#endif
+
+/*! @brief forwards to the standard allocator, counting the allocations */
+class CountingAllocator : public MatAllocator {
+private:
+	MatAllocator* base_;
+	mutable int count_;
+public:
+	explicit CountingAllocator(MatAllocator* base) : base_(base), count_(0) {}
+	int count(void) const { return count_; }
+	UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, AllocatorFlags flags, UMatUsageFlags usage) const {
+		if (!data) {
+			#ifdef _OPENMP
+			#pragma omp atomic
+			#endif
+			count_++;
+		}
+		return base_->allocate(dims, sizes, type, data, step, flags, usage);
+	}
+	bool allocate(UMatData* data, AllocatorFlags flags, UMatUsageFlags usage) const {
+		return base_->allocate(data, flags, usage);
+	}
+	void deallocate(UMatData* data) const { base_->deallocate(data); }
+};
+#endif
+
+int main(int argc, char** argv) {
+
+	// check arguments
+	if (argc != 2) {
+		printf("Usage: WorkspaceAllocations model_file\n"
+			"  model_file   an .xml, .yaml (or .mat) model, or synthetic:face or synthetic:person\n");
+		return -1;
+	}
+
+	// determine the type of model to read, or generate one
+	boost::scoped_ptr<Model> model(loadModel(argv[1]));
+	if (!model) return -2;
+
+#if CV_MAJOR_VERSION >= 3
+	PartsBasedDetector<float> pbd;
+	pbd.distributeModel(*model);
+
+	// a textured image, so that some components survive pruning
+	Mat im(Size(320, 240), CV_8UC3);
+	randu(im, Scalar::all(0), Scalar::all(255));
+
+	// once prepared, every buffer should be reused from the first frame on, in
+	// floating and fixed point, with and without root suppression
+	Detections detections;
+	int failures = 0;
+	const bool fixed[] = { false, true, false, true };
+	const bool suppressed[] = { false, false, true, true };
+	for (size_t f = 0; f < 4; ++f) {
+		pbd.setFixedPoint(fixed[f]);
+		pbd.setRootSuppression(suppressed[f] ? 3 : 0, suppressed[f] ? 50 : 0);
+		const string name = string(fixed[f] ? "fixed point" : "floating point") + (suppressed[f] ? ", suppressed" : "");
+		DetectionWorkspace workspace;
+		pbd.prepare(workspace, im.size());
+		MatAllocator* standard = Mat::getDefaultAllocator();
+		CountingAllocator counting(standard);
+		Mat::setDefaultAllocator(&counting);
+		for (int i = 0; i < 3; ++i) {
+			detections.clear();
+			pbd.detect(im, workspace, detections);
+		}
+		Mat::setDefaultAllocator(standard);
+
+		printf("%s: %d matrix allocations over 3 frames, %lu detections\n",
+				name.c_str(), counting.count(), detections.size());
+		if (counting.count() != 0) failures++;
+
+		const size_t held = workspace.bytes() + workspace.convolution->bytes();
+		const DetectionStats::Memory& memory = workspace.stats.memory;
+		printf("%s: %lu bytes accounted, %lu bytes held, %lu bytes at the peak\n",
+				name.c_str(), memory.current, held, memory.peak);
+		if (memory.current != held || memory.peak < memory.current) failures++;
+	}
+	return failures;
+#else
+	printf("Skipped: counting matrix allocations requires OpenCV 3 or later\n");
+	return 0;
+#endif
+}